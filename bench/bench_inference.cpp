@@ -0,0 +1,170 @@
+#include <benchmark/benchmark.h>
+#include <rf/quantization.h>
+#include <rf/random_forest.h>
+
+#include "synthetic.h"
+#include "synthetic_forest.h"
+
+namespace {
+
+std::vector<SyntheticPoint> generatePoints(size_t n) {
+  auto samples = generateSamples(n, 2, 2);
+  std::vector<SyntheticPoint> points{};
+  for (auto const& sample : samples) {
+    points.push_back(sample.first);
+  }
+  return points;
+}
+
+// args: depth
+template <typename Distribution>
+void BM_ForestClassify(benchmark::State& state) {
+  const auto forest = trainSyntheticForest<Distribution>(10, state.range(0), 8);
+  const auto points = generatePoints(1 << 12);
+
+  for (auto _ : state) {
+    for (auto const& point : points) {
+      benchmark::DoNotOptimize(forest.classify(point));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_TEMPLATE(BM_ForestClassify, rf::LabelDistribution)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+BENCHMARK_TEMPLATE(BM_ForestClassify, rf::DenseLabelDistribution<8>)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+
+// args: depth
+void BM_ForestClassifyBatch(benchmark::State& state) {
+  const auto forest = trainSyntheticForest<rf::DenseLabelDistribution<8>>(
+      10, state.range(0), 8);
+  const auto points = generatePoints(1 << 16);
+  std::vector<rf::Label> labels(points.size());
+
+  for (auto _ : state) {
+    forest.classifyBatch(points, rf::Span<rf::Label>{labels});
+    benchmark::DoNotOptimize(labels.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+  state.counters["bytes"] = static_cast<double>(rf::modelMemory(forest));
+}
+BENCHMARK(BM_ForestClassifyBatch)->Arg(4)->Arg(8)->Arg(16);
+
+// args: depth
+void BM_QuantizedForestClassifyBatch(benchmark::State& state) {
+  const auto forest = rf::quantizeForest<8>(
+      trainSyntheticForest<rf::DenseLabelDistribution<8>>(10, state.range(0),
+                                                          8));
+  const auto points = generatePoints(1 << 16);
+  std::vector<rf::Label> labels(points.size());
+
+  for (auto _ : state) {
+    forest.classifyBatch(points, rf::Span<rf::Label>{labels});
+    benchmark::DoNotOptimize(labels.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+  state.counters["bytes"] = static_cast<double>(rf::modelMemory(forest));
+}
+BENCHMARK(BM_QuantizedForestClassifyBatch)->Arg(4)->Arg(8)->Arg(16);
+
+// The depth 8 forest of BM_ForestClassify, exported at build time
+void BM_ExportedForestPredict(benchmark::State& state) {
+  const auto points = generatePoints(1 << 12);
+
+  for (auto _ : state) {
+    for (auto const& point : points) {
+      benchmark::DoNotOptimize(synthetic_forest::predict(point));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_ExportedForestPredict);
+
+// args: depth, interleaved
+void BM_TreeLeafIndices(benchmark::State& state) {
+  using Tree = rf::FlatTree<SyntheticSplit, rf::DenseLabelDistribution<8>>;
+
+  const auto forest = trainSyntheticForest<rf::DenseLabelDistribution<8>>(
+      1, state.range(0), 8);
+  auto const& tree = forest.trees().front();
+  const auto points = generatePoints(1 << 16);
+  std::vector<Tree::Index> leaves(points.size());
+
+  for (auto _ : state) {
+    if (state.range(1)) {
+      tree.leafIndices(points, rf::Span<Tree::Index>{leaves});
+    } else {
+      for (size_t i = 0; i < points.size(); ++i) {
+        leaves[i] = tree.leafIndex(points[i]);
+      }
+    }
+    benchmark::DoNotOptimize(leaves.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_TreeLeafIndices)
+    ->ArgsProduct({{8, 16, 24}, {0, 1}})
+    ->ArgNames({"depth", "interleaved"});
+
+// args: labels
+template <typename Distribution>
+void BM_Combine(benchmark::State& state) {
+  const auto samples = generateSamples(1024, state.range(0));
+  const auto other = Distribution{samples.begin(), samples.end()};
+  auto dist = Distribution{samples.begin(), samples.end()};
+
+  for (auto _ : state) {
+    dist.combine(other);
+    benchmark::DoNotOptimize(dist);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Combine, rf::LabelDistribution)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK_TEMPLATE(BM_Combine, rf::DenseLabelDistribution<32>)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(32);
+
+// args: labels
+template <typename Distribution>
+void BM_Entropy(benchmark::State& state) {
+  const auto samples = generateSamples(1024, state.range(0));
+  const auto dist = Distribution{samples.begin(), samples.end()};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dist.entropy());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Entropy, rf::LabelDistribution)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK_TEMPLATE(BM_Entropy, rf::DenseLabelDistribution<32>)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(32);
+BENCHMARK_TEMPLATE(BM_Entropy, rf::LabelHistogram)->Arg(2)->Arg(8)->Arg(32);
+
+// args: labels
+void BM_Gini(benchmark::State& state) {
+  const auto samples = generateSamples(1024, state.range(0));
+  const auto histogram = rf::LabelHistogram{samples.begin(), samples.end()};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(histogram.gini());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Gini)->Arg(2)->Arg(8)->Arg(32);
+
+}  // namespace
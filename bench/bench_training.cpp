@@ -0,0 +1,193 @@
+#include <benchmark/benchmark.h>
+#include <rf/flat_tree.h>
+#include <rf/tree.h>
+
+#include <cstring>
+
+#include "synthetic.h"
+
+namespace {
+
+rf::TreeParameters treeParameters(size_t maxDepth, size_t candidates) {
+  rf::TreeParameters params{};
+  params.numberOfTrees = 1;
+  params.minSamplesPerNode = 10;
+  params.maxDepth = maxDepth;
+  params.candidatesToGeneratePerNode = candidates;
+  return params;
+}
+
+// args: samples, labels
+void BM_EvaluateSplitCandidate(benchmark::State& state) {
+  const auto samples = generateSamples(state.range(0), state.range(1));
+  rf::Random rng{1};
+  const auto candidate = SyntheticSplit::generate(rng);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rf::impl::evaluateSplitCandidate(
+        candidate, samples.begin(), samples.end()));
+  }
+
+  state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(BM_EvaluateSplitCandidate)
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {2, 8, 32}});
+
+// args: samples, threads
+void BM_FindCandidate(benchmark::State& state) {
+  const auto samples = generateSamples(state.range(0), 8);
+  auto params = treeParameters(0, 100);
+  rf::ThreadPool pool{static_cast<size_t>(state.range(1))};
+  rf::Random rng{1};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rf::impl::findCandidate<SyntheticSplit>(
+        samples.begin(), samples.end(), params, pool, rng));
+  }
+
+  // every candidate is evaluated on every sample
+  state.SetItemsProcessed(state.iterations() * samples.size() *
+                          params.candidatesToGeneratePerNode);
+}
+BENCHMARK(BM_FindCandidate)
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {1, 4}})
+    ->UseRealTime();
+
+// args: samples, thresholds per feature
+void BM_FindCandidateResponse(benchmark::State& state) {
+  const auto samples = generateSamples(state.range(0), 8);
+  auto params = treeParameters(0, 100 / state.range(1));
+  params.thresholdsPerFeature = state.range(1);
+  rf::ThreadPool pool{1};
+  rf::Random rng{1};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rf::impl::findCandidate<SyntheticResponse>(
+        samples.begin(), samples.end(), params, pool, rng));
+  }
+
+  state.SetItemsProcessed(state.iterations() * samples.size() *
+                          params.candidatesToGeneratePerNode *
+                          params.thresholdsPerFeature);
+}
+BENCHMARK(BM_FindCandidateResponse)
+    ->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {1, 4, 10}});
+
+// args: samples
+void BM_FindCandidateSweep(benchmark::State& state) {
+  const auto samples = generateSamples(state.range(0), 8);
+  auto params = treeParameters(0, 10);
+  params.thresholdSearch = rf::ThresholdSearch::SWEEP;
+  rf::ThreadPool pool{1};
+  rf::Random rng{1};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rf::impl::findCandidate<SyntheticResponse>(
+        samples.begin(), samples.end(), params, pool, rng));
+  }
+
+  // every feature is evaluated once per sample
+  state.SetItemsProcessed(state.iterations() * samples.size() *
+                          params.candidatesToGeneratePerNode);
+}
+BENCHMARK(BM_FindCandidateSweep)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18);
+
+// args: samples, bins
+void BM_FindCandidateHistogram(benchmark::State& state) {
+  const auto samples = generateSamples(state.range(0), 8);
+  auto params = treeParameters(0, 10);
+  params.thresholdSearch = rf::ThresholdSearch::HISTOGRAM;
+  params.histogramBins = state.range(1);
+  rf::ThreadPool pool{1};
+  rf::Random rng{1};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rf::impl::findCandidate<SyntheticResponse>(
+        samples.begin(), samples.end(), params, pool, rng));
+  }
+
+  state.SetItemsProcessed(state.iterations() * samples.size() *
+                          params.candidatesToGeneratePerNode);
+}
+BENCHMARK(BM_FindCandidateHistogram)
+    ->ArgsProduct({{1 << 14, 1 << 18}, {64, 256}});
+
+using SyntheticTree =
+    rf::FlatTree<SyntheticSplit, rf::DenseLabelDistribution<8>>;
+
+// same nodes, splits and leaf probabilities
+bool sameTree(SyntheticTree const& a, SyntheticTree const& b) {
+  if (a.root() != b.root() || a.nodes().size() != b.nodes().size() ||
+      a.leaves().size() != b.leaves().size()) {
+    return false;
+  }
+
+  for (size_t n = 0; n < a.nodes().size(); ++n) {
+    auto const& x = a.nodes()[n];
+    auto const& y = b.nodes()[n];
+    if (x.children[0] != y.children[0] || x.children[1] != y.children[1] ||
+        std::memcmp(&x.split, &y.split, sizeof(SyntheticSplit)) != 0) {
+      return false;
+    }
+  }
+
+  for (size_t l = 0; l < a.leaves().size(); ++l) {
+    for (rf::Label label = 0; label < 8; ++label) {
+      if (a.leaves()[l].probability(label) !=
+          b.leaves()[l].probability(label)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// args: samples, depth, threads, mode
+void BM_TrainTree(benchmark::State& state) {
+  SyntheticTrainSet train{generateSamples(state.range(0), 8)};
+  auto params = treeParameters(state.range(1), 20);
+  params.trainingMode = static_cast<rf::TrainingMode>(state.range(3));
+  rf::ThreadPool pool{static_cast<size_t>(state.range(2))};
+
+  // the modes only differ in the order the work is done
+  if (params.trainingMode == rf::TrainingMode::BREADTH_FIRST) {
+    auto depthFirst = params;
+    depthFirst.trainingMode = rf::TrainingMode::DEPTH_FIRST;
+    const auto expected = rf::compileTree<SyntheticSplit>(
+        rf::trainTree<SyntheticSplit, rf::DenseLabelDistribution<8>>(
+            train, train, depthFirst, pool));
+    const auto levels = rf::compileTree<SyntheticSplit>(
+        rf::trainTree<SyntheticSplit, rf::DenseLabelDistribution<8>>(
+            train, train, params, pool));
+    if (!sameTree(expected, levels)) {
+      state.SkipWithError("the training modes grew different trees");
+      return;
+    }
+  }
+
+  size_t nodes = 0;
+  for (auto _ : state) {
+    auto tree = rf::trainTree<SyntheticSplit, rf::DenseLabelDistribution<8>>(
+        train, train, params, pool);
+
+    state.PauseTiming();
+    auto flat = rf::compileTree<SyntheticSplit>(tree);
+    nodes += flat.nodes().size() + flat.leaves().size();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["nodes/s"] =
+      benchmark::Counter(static_cast<double>(nodes), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_TrainTree)
+    ->ArgsProduct({{1 << 12, 1 << 16},
+                   {4, 8, 16},
+                   {1, 4},
+                   {static_cast<int64_t>(rf::TrainingMode::DEPTH_FIRST),
+                    static_cast<int64_t>(rf::TrainingMode::BREADTH_FIRST)}})
+    ->ArgNames({"samples", "depth", "threads", "mode"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,26 @@
+#include <rf/codegen.h>
+
+#include <iostream>
+
+#include "synthetic.h"
+
+/**
+ *  Write the forest BM_ExportedForestPredict evaluates to the given header
+ */
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <header>\n";
+    return 1;
+  }
+
+  const auto forest =
+      trainSyntheticForest<rf::DenseLabelDistribution<8>>(10, 8, 8);
+
+  rf::ExportOptions options{};
+  options.namespaceName = "synthetic_forest";
+  options.splitType = "SyntheticSplit";
+  options.inputType = "SyntheticPoint";
+  options.includes = {"\"synthetic.h\""};
+  rf::exportForest(forest, std::string{argv[1]}, options);
+  return 0;
+}
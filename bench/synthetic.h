@@ -0,0 +1,192 @@
+#pragma once
+
+#include <rf/codegen.h>
+#include <rf/feature_response.h>
+#include <rf/half.h>
+#include <rf/random.h>
+#include <rf/random_forest.h>
+#include <rf/split_candidate.h>
+#include <rf/train_set.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+/**
+ *  Synthetic data for the benchmarks, no dataset needed.
+ *
+ *  Every point has a few uniform features in [0, 1). The label is given by
+ *  the first feature, with some of the labels replaced by noise so the trees
+ *  keep growing until the stopping criteria.
+ */
+struct SyntheticPoint {
+  static constexpr size_t kFeatures = 8;
+  std::array<float, kFeatures> features{};
+};
+
+/**
+ *  SyntheticSplit with an 8-bit feature index and a float16 threshold
+ */
+class QuantizedSyntheticSplit
+    : public rf::SplitCandidate<QuantizedSyntheticSplit, SyntheticPoint> {
+ public:
+  rf::SplitResult classify(SyntheticPoint const& p) const noexcept {
+    return p.features[feature_] < threshold_.toFloat() ? rf::SplitResult::LEFT
+                                                       : rf::SplitResult::RIGHT;
+  }
+
+  QuantizedSyntheticSplit() = default;
+  QuantizedSyntheticSplit(uint8_t feature, rf::Half threshold) noexcept
+      : feature_{feature}, threshold_{threshold} {}
+
+ private:
+  uint8_t feature_{0};
+  rf::Half threshold_{};
+};
+
+/**
+ *  Axis aligned split: compare one feature against a threshold
+ */
+class SyntheticSplit
+    : public rf::SplitCandidate<SyntheticSplit, SyntheticPoint> {
+ public:
+  rf::SplitResult classify(SyntheticPoint const& p) const noexcept {
+    return p.features[feature_] < threshold_ ? rf::SplitResult::LEFT
+                                             : rf::SplitResult::RIGHT;
+  }
+
+  static SyntheticSplit generate(rf::Random& rng) {
+    std::uniform_int_distribution<uint32_t> featureDist{
+        0, SyntheticPoint::kFeatures - 1};
+    std::uniform_real_distribution<float> thresholdDist{0.0f, 1.0f};
+    return SyntheticSplit{featureDist(rng), thresholdDist(rng)};
+  }
+
+  QuantizedSyntheticSplit quantize() const noexcept {
+    return QuantizedSyntheticSplit{static_cast<uint8_t>(feature_),
+                                   rf::Half{threshold_}};
+  }
+
+  // constructor expression, for rf::exportForest
+  void writeSource(std::ostream& os) const {
+    os << "SyntheticSplit{" << feature_ << "u, ";
+    rf::writeLiteral(os, threshold_);
+    os << '}';
+  }
+
+  SyntheticSplit() = default;
+  SyntheticSplit(uint32_t feature, float threshold) noexcept
+      : feature_{feature}, threshold_{threshold} {}
+
+ private:
+  uint32_t feature_{0};
+  float threshold_{0.0f};
+};
+
+/**
+ *  Same split through the feature response interface
+ */
+class SyntheticResponse
+    : public rf::FeatureResponse<SyntheticResponse, SyntheticPoint> {
+ public:
+  float response(SyntheticPoint const& p) const noexcept {
+    return p.features[feature_];
+  }
+
+  static SyntheticResponse generate(rf::Random& rng) {
+    std::uniform_int_distribution<uint32_t> featureDist{
+        0, SyntheticPoint::kFeatures - 1};
+    std::uniform_real_distribution<float> thresholdDist{0.0f, 1.0f};
+    return SyntheticResponse{featureDist(rng), thresholdDist(rng)};
+  }
+
+  SyntheticResponse() = default;
+  SyntheticResponse(uint32_t feature, float threshold) noexcept
+      : FeatureResponse{threshold}, feature_{feature} {}
+
+ private:
+  uint32_t feature_{0};
+};
+
+using SyntheticExample = rf::TrainingExample<SyntheticPoint>;
+
+inline std::vector<SyntheticExample> generateSamples(size_t n, size_t labels,
+                                                     uint64_t seed = 1) {
+  rf::Random rng{seed};
+  std::uniform_real_distribution<float> featureDist{0.0f, 1.0f};
+  std::uniform_int_distribution<size_t> labelDist{0, labels - 1};
+  std::bernoulli_distribution noise{0.1};
+
+  std::vector<SyntheticExample> samples(n);
+  for (auto& sample : samples) {
+    for (auto& feature : sample.first.features) {
+      feature = featureDist(rng);
+    }
+
+    auto label = static_cast<size_t>(sample.first.features[0] * labels);
+    if (noise(rng)) {
+      label = labelDist(rng);
+    }
+    sample.second = static_cast<rf::Label>(label);
+  }
+
+  return samples;
+}
+
+/**
+ *  Train set returning the same in-memory samples for every tree
+ */
+class SyntheticTrainSet : public rf::TrainSet<SyntheticPoint> {
+ public:
+  explicit SyntheticTrainSet(std::vector<SyntheticExample> samples)
+      : samples_{std::move(samples)} {}
+
+  std::vector<SyntheticExample> sample(rf::Random&) override {
+    return samples_;
+  }
+
+  std::unique_ptr<TrainSetIterator> iter() override {
+    return std::make_unique<Iterator>(samples_);
+  }
+
+ private:
+  class Iterator : public TrainSetIterator {
+   public:
+    explicit Iterator(std::vector<SyntheticExample> const& samples)
+        : samples_{samples} {}
+
+    void next() override { ++index_; }
+    std::optional<SyntheticExample> value() override {
+      if (index_ < samples_.size()) {
+        return samples_[index_];
+      }
+      return std::nullopt;
+    }
+
+   private:
+    std::vector<SyntheticExample> const& samples_;
+    size_t index_{0};
+  };
+
+  std::vector<SyntheticExample> samples_{};
+};
+
+/**
+ *  Forest of SyntheticSplit trained on the synthetic samples, always the same
+ *  for the same arguments
+ */
+template <typename Distribution>
+rf::RandomForest<SyntheticSplit, Distribution> trainSyntheticForest(
+    size_t trees, size_t maxDepth, size_t labels) {
+  SyntheticTrainSet train{generateSamples(1 << 14, labels)};
+
+  rf::TreeParameters params{};
+  params.numberOfTrees = trees;
+  params.minSamplesPerNode = 2;
+  params.maxDepth = maxDepth;
+  params.candidatesToGeneratePerNode = 20;
+
+  rf::RandomForest<SyntheticSplit, Distribution> forest{};
+  forest.train(train, train, params);
+  return forest;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <rf/dense_label_distribution.h>
+#include <rf/random_forest.h>
+#include <rf/thread_pool.h>
+
+#include <algorithm>
+#include <opencv4/opencv2/core.hpp>
+#include <stdexcept>
+#include <vector>
+
+#include "pixel_classifier.h"
+
+/**
+ *
+ *  Classifies every pixel of a depth frame at once, instead of one
+ *  PixelReference at a time.
+ *
+ *  The frame is copied once into a buffer with a zero border as wide as the
+ *  largest offset of the forest, the depth outside the image reads 0 as with
+ *  Image::getDepthValue, so the splits read it without any bounds check. The
+ *  frame is then cut into tiles classified in parallel: every tree walks all
+ *  the pixels of a tile before the next one, so the tile with its guard band
+ *  and the tree stay in cache.
+ *
+ */
+template <size_t NumLabels>
+class DenseClassifier {
+ public:
+  using Distribution = rf::DenseLabelDistribution<NumLabels>;
+  using Forest = rf::RandomForest<PixelClassifier, Distribution>;
+
+  struct Result {
+    // CV_8UC1 label of every pixel
+    cv::Mat labels{};
+    // CV_32F probability of every pixel, one map per label
+    std::vector<cv::Mat> probabilities{};
+  };
+
+  /**
+   *  The forest has to outlive the classifier. Zero threads uses one per
+   *  hardware thread.
+   */
+  explicit DenseClassifier(Forest const& forest, size_t threads = 0,
+                           int tileSize = 32);
+
+  /**
+   *  Same labels and probabilities as Forest::classify on every pixel of the
+   *  CV_32F depth frame.
+   */
+  Result classify(cv::Mat const& depth);
+
+ private:
+  void classifyTile(cv::Mat const& padded, int top, int left, int rows,
+                    int cols, Result& result) const;
+
+  Forest const& forest_;
+  rf::ThreadPool pool_;
+  int tileSize_{32};
+  // largest offset of the splits of the forest
+  int guard_{0};
+};
+
+template <size_t NumLabels>
+DenseClassifier<NumLabels>::DenseClassifier(Forest const& forest,
+                                            size_t threads, int tileSize)
+    : forest_{forest}, pool_{threads}, tileSize_{std::max(1, tileSize)} {
+  for (auto const& tree : forest_.trees()) {
+    for (auto const& node : tree.nodes()) {
+      guard_ = std::max(guard_, node.split.maxOffset());
+    }
+  }
+}
+
+template <size_t NumLabels>
+typename DenseClassifier<NumLabels>::Result
+DenseClassifier<NumLabels>::classify(cv::Mat const& depth) {
+  if (depth.type() != CV_32F) {
+    throw std::invalid_argument("the depth frame has to be CV_32F");
+  }
+
+  cv::Mat padded;
+  cv::copyMakeBorder(depth, padded, guard_, guard_, guard_, guard_,
+                     cv::BORDER_CONSTANT, cv::Scalar(0));
+
+  Result result{cv::Mat(depth.rows, depth.cols, CV_8UC1), {}};
+  for (size_t label = 0; label < NumLabels; ++label) {
+    result.probabilities.emplace_back(depth.rows, depth.cols, CV_32F);
+  }
+
+  rf::TaskGroup tiles{pool_};
+  for (int top = 0; top < depth.rows; top += tileSize_) {
+    for (int left = 0; left < depth.cols; left += tileSize_) {
+      const auto rows = std::min(tileSize_, depth.rows - top);
+      const auto cols = std::min(tileSize_, depth.cols - left);
+      tiles.run([this, &padded, &result, top, left, rows, cols] {
+        classifyTile(padded, top, left, rows, cols, result);
+      });
+    }
+  }
+  tiles.wait();
+
+  return result;
+}
+
+template <size_t NumLabels>
+void DenseClassifier<NumLabels>::classifyTile(cv::Mat const& padded, int top,
+                                              int left, int rows, int cols,
+                                              Result& result) const {
+  using Tree = rf::FlatTree<PixelClassifier, Distribution>;
+  const auto stride = static_cast<ptrdiff_t>(padded.step1());
+
+  // combined like Forest::classify, one tree at a time
+  std::vector<Distribution> pixels(static_cast<size_t>(rows) * cols);
+  for (auto const& tree : forest_.trees()) {
+    const auto nodes = tree.nodes();
+    const auto leaves = tree.leaves();
+
+    for (int row = 0; row < rows; ++row) {
+      auto const* center =
+          padded.ptr<float>(top + row + guard_) + left + guard_;
+      auto* dist = pixels.data() + static_cast<size_t>(row) * cols;
+
+      for (int col = 0; col < cols; ++col) {
+        auto index = tree.root();
+        while (!(index & Tree::kLeaf)) {
+          auto const& node = nodes[index];
+          index = node.children[static_cast<size_t>(
+              node.split.classify(center + col, stride))];
+        }
+        dist[col].combine(leaves[index & ~Tree::kLeaf]);
+      }
+    }
+  }
+
+  cv::Mat& labelMap = result.labels;
+  for (int row = 0; row < rows; ++row) {
+    auto const* dist = pixels.data() + static_cast<size_t>(row) * cols;
+    auto* labels = labelMap.ptr<uint8_t>(top + row) + left;
+    for (int col = 0; col < cols; ++col) {
+      labels[col] = dist[col].maxProb().first;
+    }
+
+    for (size_t label = 0; label < NumLabels; ++label) {
+      cv::Mat& probabilityMap = result.probabilities[label];
+      auto* probabilities = probabilityMap.ptr<float>(top + row) + left;
+      for (int col = 0; col < cols; ++col) {
+        probabilities[col] = static_cast<float>(
+            dist[col].probability(static_cast<rf::Label>(label)));
+      }
+    }
+  }
+}
@@ -36,29 +36,80 @@ class ColorImageHandler : public ImageHandler {
   cv::Mat img_{};
 };
 
+/**
+ *
+ *  Color image of a DecodedImage, only its path and size are known: neither
+ *  the training nor the classification use the colors.
+ *
+ */
+class ColorPathHandler : public ImageHandler {
+ public:
+  ColorPathHandler(fs::path const& path, int rows, int cols) noexcept
+      : ImageHandler(path), rows_{rows}, cols_{cols} {}
+
+ public:  // ImageHandle
+  void load() override {}
+  void release() override {}
+
+  int rows() const noexcept override { return rows_; }
+  int cols() const noexcept override { return cols_; }
+
+ private:
+  int rows_{0};
+  int cols_{0};
+};
+
+namespace {
+
+// Matrix header over the pixels of a DecodedImage, nothing is copied
+cv::Mat decodedMat(DecodedImage const& image, int type, void const* data) {
+  return cv::Mat(image.rows, image.cols, type, const_cast<void*>(data));
+}
+
+}  // namespace
+
+/**
+ *
+ *  The depth is read into a buffer laid out by depthLayout(), with
+ *  kDepthPadding zeros around the image, so the splits read it without
+ *  checks. A decoded image is
+ *  already padded and used in place.
+ *
+ */
 class DepthImageHandler : public ImageHandler {
  public:
   DepthImageHandler(fs::path const& path) noexcept : ImageHandler(path) {}
+  DepthImageHandler(DecodedImage const& image)
+      : ImageHandler(fs::path{}),
+        decoded_{image.rows, image.cols, CV_32F,
+                 const_cast<float*>(image.depth),
+                 static_cast<size_t>(image.depthStride) * sizeof(float)},
+        decodedView_{image.depth, image.depthStride},
+        storage_{image.storage} {}
 
-  [[nodiscard]] double getValue(int row, int col) const noexcept {
-    if (loaded_ && row >= 0 && row < img_.rows && col >= 0 && col < img_.cols) {
-      return img_.at<float>(row, col);
-    }
-    return 0.0;
-  }
+  [[nodiscard]] DepthView view() const noexcept { return view_; }
+  [[nodiscard]] cv::Mat const& mat() const noexcept { return img_; }
 
  public:  // ImageHandle
   void load() override {
     if (!loaded_) {
-      img_ =
-          cv::imread(path_.string(), cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR);
-      img_.convertTo(img_, CV_32F);
+      if (!decoded_.empty()) {
+        view_ = decodedView_;
+        img_ = decoded_;
+      } else {
+        auto img = cv::imread(path_.string(),
+                              cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR);
+        img.convertTo(img, CV_32F);
+        pad(img);
+      }
       loaded_ = true;
     }
   }
   void release() override {
     if (loaded_) {
-      img_.release();
+      std::vector<float>{}.swap(padded_);
+      img_ = cv::Mat{};
+      view_ = DepthView{};
       loaded_ = false;
     }
   }
@@ -67,8 +118,30 @@ class DepthImageHandler : public ImageHandler {
   int cols() const noexcept override { return img_.cols; }
 
  private:
+  void pad(cv::Mat const& img) {
+    const auto layout = depthLayout(img.rows, img.cols);
+    const auto stride = static_cast<ptrdiff_t>(layout.stride);
+    padded_.assign(layout.size, 0.0f);
+
+    auto* origin = padded_.data() + layout.origin;
+    for (int row = 0; row < img.rows; ++row) {
+      auto const* src = img.ptr<float>(row);
+      std::copy(src, src + img.cols, origin + row * stride);
+    }
+
+    view_ = DepthView{origin, stride};
+    img_ = cv::Mat(img.rows, img.cols, CV_32F, origin,
+                   layout.stride * sizeof(float));
+  }
+
   bool loaded_{false};
+  std::vector<float> padded_{};
+  DepthView view_{};
+  // header over the image inside the padding
   cv::Mat img_{};
+  cv::Mat decoded_{};
+  DepthView decodedView_{};
+  std::shared_ptr<const void> storage_{};
 };
 
 /**
@@ -80,6 +153,11 @@ class DepthImageHandler : public ImageHandler {
 class LabelImageHandler : public ImageHandler {
  public:
   LabelImageHandler(fs::path const& path) : ImageHandler(path) {}
+  LabelImageHandler(DecodedImage const& image)
+      : ImageHandler(fs::path{}),
+        loaded_{true},
+        img_{decodedMat(image, CV_8UC1, image.mask)},
+        storage_{image.storage} {}
 
   bool isLabeled(int row, int col) const noexcept {
     if (loaded_ && row >= 0 && row < img_.rows && col >= 0 && col < img_.cols) {
@@ -104,7 +182,8 @@ class LabelImageHandler : public ImageHandler {
   }
 
   void release() override {
-    if (loaded_) {
+    // decoded images stay loaded
+    if (loaded_ && !storage_) {
       img_.release();
       loaded_ = false;
     }
@@ -116,29 +195,42 @@ class LabelImageHandler : public ImageHandler {
  private:
   bool loaded_{false};
   cv::Mat img_{};
+  std::shared_ptr<const void> storage_{};
 };
 
 Image::Image(fs::path const& color, fs::path const& depth)
     : color_(new ColorImageHandler(color)),
-      depth_(new DepthImageHandler(depth)) {}
+      depthHandler_(new DepthImageHandler(depth)) {}
+Image::Image(std::unique_ptr<ImageHandler>&& color,
+             std::unique_ptr<ImageHandler>&& depth) noexcept
+    : color_(std::move(color)), depthHandler_(std::move(depth)) {}
 Image::~Image() {}
 
 void Image::load() {
   color_->load();
-  depth_->load();
+  depthHandler_->load();
+  depth_ = static_cast<DepthImageHandler const&>(*depthHandler_).view();
 }
 
 void Image::release() {
   color_->release();
-  depth_->release();
+  depthHandler_->release();
+  depth_ = DepthView{};
 }
 
 int Image::rows() const noexcept { return color_->rows(); }
 int Image::cols() const noexcept { return color_->cols(); }
 
 double Image::getDepthValue(int row, int col) const noexcept {
-  auto img = dynamic_cast<DepthImageHandler*>(depth_.get());
-  return img->getValue(row, col);
+  if (depth_.origin && row >= 0 && row < depthHandler_->rows() && col >= 0 &&
+      col < depthHandler_->cols()) {
+    return *depth_.at(row, col);
+  }
+  return 0.0;
+}
+
+cv::Mat const& Image::getDepth() const noexcept {
+  return static_cast<DepthImageHandler const&>(*depthHandler_).mat();
 }
 
 LabeledImage::LabeledImage(fs::path const& color, fs::path const& depth,
@@ -148,6 +240,14 @@ LabeledImage::LabeledImage(fs::path const& color, fs::path const& depth,
       Image(color, depth),
       label_{label},
       bgLabel_{defaultLabel} {}
+LabeledImage::LabeledImage(DecodedImage const& image, rf::Label label,
+                           rf::Label defaultLabel)
+    : Image(std::make_unique<ColorPathHandler>(image.color, image.rows,
+                                               image.cols),
+            std::make_unique<DepthImageHandler>(image)),
+      label_{label},
+      bgLabel_{defaultLabel},
+      labels_{std::make_unique<LabelImageHandler>(image)} {}
 LabeledImage::~LabeledImage() {}
 
 void LabeledImage::load() {
@@ -160,6 +260,13 @@ void LabeledImage::release() {
   labels_->release();
 }
 
+size_t LabeledImage::memory() const noexcept {
+  const auto rows = static_cast<size_t>(this->rows());
+  const auto cols = static_cast<size_t>(this->cols());
+  return rows * cols * (3 * sizeof(uint8_t) + sizeof(uint8_t)) +
+         depthLayout(rows, cols).size * sizeof(float);
+}
+
 rf::Label LabeledImage::getLabelValue(int row, int col) const noexcept {
   auto image = dynamic_cast<LabelImageHandler*>(labels_.get());
   if (image->isLabeled(row, col)) {
@@ -170,16 +277,15 @@ rf::Label LabeledImage::getLabelValue(int row, int col) const noexcept {
 }
 
 std::vector<PixelReference> sampleLabeledPixels(LabeledImage const& image,
-                                                size_t n) {
+                                                size_t n, rf::Random& rng) {
   std::vector<PixelReference> samples;
-  auto gen = std::mt19937(std::random_device{}());
-  auto rowDist = std::uniform_int_distribution<int>{0, image.rows()};
-  auto colDist = std::uniform_int_distribution<int>{0, image.cols()};
+  auto rowDist = std::uniform_int_distribution<int>{0, image.rows() - 1};
+  auto colDist = std::uniform_int_distribution<int>{0, image.cols() - 1};
 
   for (size_t i = 0; i < n; ++i) {
-    const auto row = rowDist(gen);
-    const auto col = colDist(gen);
-    samples.emplace_back(PixelReference(image, rowDist(gen), colDist(gen)));
+    const auto row = rowDist(rng);
+    const auto col = colDist(rng);
+    samples.emplace_back(PixelReference(image, row, col));
   }
 
   return samples;
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <rf/label.h>
+#include <rf/random.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+namespace cv {
+class Mat;
+}
+
 class ImageHandler {
  public:
   ImageHandler(fs::path const& path) noexcept : path_{path} {}
@@ -27,6 +34,67 @@ class ImageHandler {
 
 class PixelReference;
 
+/**
+ *  Depth values read up to this many pixels outside of a loaded image are 0
+ *  without any check. The splits keep their offsets within it.
+ */
+constexpr int kDepthPadding = 64;
+
+/**
+ *  Buffer of the padded depth of a rows * cols image. Rows are `stride`
+ *  floats apart, the kDepthPadding zeros after a row also pad the next one on
+ *  the left. kDepthPadding rows of zeros go above and below the image, and
+ *  kDepthPadding more zeros before them for the left of the first row.
+ */
+struct DepthLayout {
+  size_t stride{0};
+  // index of the first pixel
+  size_t origin{0};
+  // floats in the buffer
+  size_t size{0};
+};
+
+[[nodiscard]] constexpr DepthLayout depthLayout(size_t rows,
+                                                size_t cols) noexcept {
+  const auto stride = cols + kDepthPadding;
+  return {stride, kDepthPadding + kDepthPadding * stride,
+          kDepthPadding + (rows + 2 * kDepthPadding) * stride};
+}
+
+/**
+ *  Depth of a loaded image, rows are `stride` floats apart. Reads are not
+ *  checked, they must stay within kDepthPadding pixels of the image.
+ */
+struct DepthView {
+  float const* origin{nullptr};
+  ptrdiff_t stride{0};
+
+  [[nodiscard]] float const* at(int row, int col) const noexcept {
+    return origin + row * stride + col;
+  }
+};
+
+/**
+ *
+ *  Pixels of an image decoded ahead of time, e.g. read from a PackedDataset.
+ *  The depth is already padded as depthLayout() describes. Images built from
+ *  it use the pixels in place, nothing is copied when they are loaded, and
+ *  keep `storage` alive.
+ *
+ */
+struct DecodedImage {
+  fs::path color{};
+  int rows{0};
+  int cols{0};
+  // first of the rows * cols depth values, in a buffer laid out as
+  // depthLayout() describes
+  float const* depth{nullptr};
+  ptrdiff_t depthStride{0};
+  // rows * cols mask values, labeled when not zero
+  uint8_t const* mask{nullptr};
+  std::shared_ptr<const void> storage{};
+};
+
 /**
  *
  *  This is the class used to hold the information to be classified.
@@ -49,16 +117,27 @@ class Image {
   int rows() const noexcept;
   int cols() const noexcept;
 
+  // Checked read of the depth, 0 outside of the image or if not loaded
   [[nodiscard]] double getDepthValue(int row, int col) const noexcept;
+  [[nodiscard]] DepthView const& depth() const noexcept { return depth_; }
+  // CV_32F depth of a loaded image
+  [[nodiscard]] cv::Mat const& getDepth() const noexcept;
   [[nodiscard]] fs::path getColorPath() const noexcept {
     return color_->path();
   }
+  [[nodiscard]] fs::path getDepthPath() const noexcept {
+    return depthHandler_->path();
+  }
 
   [[nodiscard]] PixelReference ref(int row, int col) const noexcept;
 
  protected:
+  Image(std::unique_ptr<ImageHandler>&& color,
+        std::unique_ptr<ImageHandler>&& depth) noexcept;
+
   std::unique_ptr<ImageHandler> color_{nullptr};
-  std::unique_ptr<ImageHandler> depth_{nullptr};
+  std::unique_ptr<ImageHandler> depthHandler_{nullptr};
+  DepthView depth_{};
 };
 
 /**
@@ -97,6 +176,10 @@ class LabeledImage : public Image {
   LabeledImage(fs::path const& color, fs::path const& depth,
                fs::path const& labels, rf::Label label, rf::Label bgLabel);
 
+  // Image already decoded, the mask is always loaded and loading the image
+  // only pads the depth. The color image is only known by its path.
+  LabeledImage(DecodedImage const& image, rf::Label label, rf::Label bgLabel);
+
   ~LabeledImage();
   LabeledImage(LabeledImage&&) = default;
   LabeledImage& operator=(LabeledImage&&) = default;
@@ -105,10 +188,17 @@ class LabeledImage : public Image {
   void release() override;
 
   [[nodiscard]] rf::Label getLabelValue(int row, int col) const noexcept;
+  // Bytes held while loaded: color and label channels and the padded depth
+  [[nodiscard]] size_t memory() const noexcept;
+  [[nodiscard]] fs::path getLabelPath() const noexcept {
+    return labels_->path();
+  }
+  [[nodiscard]] rf::Label label() const noexcept { return label_; }
+  [[nodiscard]] rf::Label bgLabel() const noexcept { return bgLabel_; }
 
  protected:
   friend std::vector<PixelReference> sampleLabeledPixels(
-      LabeledImage const& image, size_t n);
+      LabeledImage const& image, size_t n, rf::Random& rng);
 
   rf::Label label_{};
   rf::Label bgLabel_{};
@@ -121,4 +211,4 @@ class LabeledImage : public Image {
  *
  */
 std::vector<PixelReference> sampleLabeledPixels(LabeledImage const& image,
-                                                size_t n);
+                                                size_t n, rf::Random& rng);
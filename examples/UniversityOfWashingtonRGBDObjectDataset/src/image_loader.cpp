@@ -0,0 +1,128 @@
+#include "image_loader.h"
+
+#include <algorithm>
+
+ImageLoader::ImageLoader(size_t threads, size_t capacity)
+    : capacity_{std::max<size_t>(2, capacity)} {
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this] { decode(); });
+  }
+}
+
+ImageLoader::~ImageLoader() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stop_ = true;
+  }
+  changed_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+
+  for (auto& [image, pending] : pending_) {
+    if (pending.loaded) {
+      image->release();
+    }
+  }
+}
+
+void ImageLoader::prefetch(LabeledImage& image, Priority priority) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto [it, inserted] = pending_.try_emplace(&image);
+    auto& pending = it->second;
+    if (!inserted) {
+      if (priority == Priority::BACKGROUND || pending.started ||
+          pending.priority == Priority::URGENT) {
+        return;
+      }
+      queue_.erase(std::find(queue_.begin(), queue_.end(), &image));
+    }
+
+    pending.priority = priority;
+    (priority == Priority::URGENT ? urgent_ : queue_).push_back(&image);
+  }
+  changed_.notify_all();
+}
+
+void ImageLoader::acquire(LabeledImage& image) {
+  std::unique_lock<std::mutex> lock{mutex_};
+  auto it = pending_.find(&image);
+  if (it == pending_.end() || !it->second.started) {
+    if (it != pending_.end()) {
+      auto& queue =
+          it->second.priority == Priority::URGENT ? urgent_ : queue_;
+      queue.erase(std::find(queue.begin(), queue.end(), &image));
+      pending_.erase(it);
+    }
+    lock.unlock();
+    image.load();
+    return;
+  }
+
+  // references to the entries stay valid while other images are queued
+  auto& pending = it->second;
+  changed_.wait(lock, [&] { return pending.loaded; });
+  auto error = pending.error;
+  if (pending.priority == Priority::BACKGROUND) {
+    --backgroundAhead_;
+    backgroundMemory_ -= pending.memory;
+  }
+  pending_.erase(&image);
+  --ahead_;
+  lock.unlock();
+  changed_.notify_all();
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+size_t ImageLoader::backgroundMemory() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return backgroundMemory_;
+}
+
+void ImageLoader::decode() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    // the BACKGROUND images leave a slot to the URGENT ones
+    auto urgent = [this] { return !urgent_.empty() && ahead_ < capacity_; };
+    auto background = [this] {
+      return !queue_.empty() && backgroundAhead_ + 1 < capacity_ &&
+             ahead_ < capacity_;
+    };
+    changed_.wait(lock, [&] { return stop_ || urgent() || background(); });
+    if (stop_) {
+      return;
+    }
+
+    auto& queue = urgent() ? urgent_ : queue_;
+    auto* image = queue.front();
+    queue.pop_front();
+    auto& pending = pending_[image];
+    pending.started = true;
+    ++ahead_;
+    if (pending.priority == Priority::BACKGROUND) {
+      ++backgroundAhead_;
+    }
+    lock.unlock();
+
+    std::exception_ptr error{};
+    try {
+      image->load();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    auto& loaded = pending_[image];
+    loaded.loaded = true;
+    loaded.error = error;
+    if (loaded.priority == Priority::BACKGROUND && !error) {
+      loaded.memory = image->memory();
+      backgroundMemory_ += loaded.memory;
+    }
+    changed_.notify_all();
+  }
+}
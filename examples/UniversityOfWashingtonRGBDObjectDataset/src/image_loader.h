@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "image.h"
+
+/**
+ *
+ *  Loads images on background threads, so reading and decoding the files
+ *  overlaps with the training.
+ *
+ *  Images queued with prefetch() are loaded in order by the decoder threads,
+ *  the URGENT ones before the others. At most `capacity` of them are loaded
+ *  ahead, the decoders wait until acquire() takes them, and one of these
+ *  slots is kept for the URGENT images. Images prefetched and never acquired
+ *  are released when the loader is destroyed.
+ *
+ */
+class ImageLoader {
+ public:
+  enum class Priority {
+    // needed soon, e.g. the next chunk of the tree in training
+    URGENT,
+    // needed later, e.g. the images of the next tree
+    BACKGROUND
+  };
+
+  // capacity is at least 2, a slot for the BACKGROUND images and one for the
+  // URGENT ones
+  ImageLoader(size_t threads, size_t capacity);
+  ~ImageLoader();
+
+  ImageLoader(ImageLoader const&) = delete;
+  ImageLoader& operator=(ImageLoader const&) = delete;
+
+  // Queue the image to be loaded, unless it is already queued. An URGENT
+  // image already queued and not started moves ahead of the BACKGROUND ones.
+  // The image must not be loaded nor used by other threads until it is
+  // acquired.
+  void prefetch(LabeledImage& image, Priority priority = Priority::BACKGROUND);
+
+  // Wait for the image to be loaded. Images that are not queued, or that no
+  // decoder started yet, are loaded on the calling thread.
+  void acquire(LabeledImage& image);
+
+  // Bytes of the BACKGROUND images loaded and not acquired yet
+  [[nodiscard]] size_t backgroundMemory() const;
+
+ private:
+  struct Pending {
+    Priority priority{Priority::BACKGROUND};
+    bool started{false};
+    bool loaded{false};
+    size_t memory{0};
+    std::exception_ptr error{};
+  };
+
+  void decode();
+
+  size_t capacity_{0};
+  mutable std::mutex mutex_{};
+  std::condition_variable changed_{};
+  // waiting for a decoder
+  std::deque<LabeledImage*> urgent_{};
+  std::deque<LabeledImage*> queue_{};
+  // queued, loading or loaded and not acquired yet
+  std::unordered_map<LabeledImage*, Pending> pending_{};
+  // started by a decoder and not acquired yet, and the BACKGROUND ones
+  size_t ahead_{0};
+  size_t backgroundAhead_{0};
+  // loaded BACKGROUND images not acquired yet
+  size_t backgroundMemory_{0};
+  bool stop_{false};
+  std::vector<std::thread> threads_{};
+};
@@ -10,35 +10,64 @@ void ImagePool::append(std::vector<LabeledImage>&& images) {
                std::make_move_iterator(images.end()));
 }
 
-void ImagePool::shuffle() {
-  std::random_device rd;
-  std::mt19937 g(rd());
-  std::shuffle(pool_.begin(), pool_.end(), g);
+void ImagePool::shuffle(rf::Random& rng) {
+  std::shuffle(pool_.begin(), pool_.end(), rng);
 }
 
 size_t TrainingSet::size() const noexcept {
   return std::distance(begin_, end_);
 }
 
-std::vector<TrainingExample> TrainingSet::sample() {
+namespace {
+
+// the images a sample takes pixels from
+std::vector<std::reference_wrapper<LabeledImage>> drawImages(
+    ImageIterator begin, ImageIterator end, size_t n, rf::Random& rng) {
+  std::vector<std::reference_wrapper<LabeledImage>> images;
+  std::sample(begin, end, std::back_inserter(images), n, rng);
+  return images;
+}
+
+}  // namespace
+
+std::vector<TrainingExample> TrainingSet::sample(rf::Random& rng) {
   std::vector<TrainingExample> samples;
+  auto images = drawImages(begin_, end_, samplesPerClass_, rng);
 
-  // Release the images
-  for (auto& img : loadedImages_) {
-    img.get().release();
+  // load the images, unless a previous sample still uses them
+  std::vector<bool> load(images.size(), false);
+  for (size_t i = 0; i < images.size(); ++i) {
+    auto& img = images[i];
+    auto [it, inserted] =
+        loadedImages_.try_emplace(&img.get(), LoadedImage{img, 0});
+    load[i] = inserted;
+    it->second.samples++;
+    if (inserted && loader_) {
+      loader_->prefetch(img);
+    }
   }
 
-  loadedImages_.clear();
-  std::sample(begin_, end_, std::back_inserter(loadedImages_), samplesPerClass_,
-              std::mt19937{std::random_device{}()});
+  for (size_t i = 0; i < images.size(); ++i) {
+    const auto& image = images[i];
+    if (load[i] && loader_) {
+      loader_->acquire(image);
+    } else if (load[i]) {
+      image.get().load();
+    }
 
-  // load the images
-  for (auto& img : loadedImages_) {
-    img.get().load();
-  }
+    auto pixels = sampleLabeledPixels(image, samplesPerImage_, rng);
+
+    // release() only finds the images of the samples, an image without
+    // pixels is not used by this sample
+    if (pixels.empty()) {
+      auto it = loadedImages_.find(&image.get());
+      if (--it->second.samples == 0) {
+        it->second.image.get().release();
+        loadedImages_.erase(it);
+      }
+      continue;
+    }
 
-  for (const auto& image : loadedImages_) {
-    auto pixels = sampleLabeledPixels(image, samplesPerImage_);
     std::transform(pixels.begin(), pixels.end(), std::back_inserter(samples),
                    [&](const auto& pixelReference) {
                      const auto label = image.get().getLabelValue(
@@ -50,6 +79,35 @@ std::vector<TrainingExample> TrainingSet::sample() {
   return samples;
 }
 
+void TrainingSet::prefetch(rf::Random rng) {
+  if (loader_ == nullptr) {
+    return;
+  }
+
+  for (auto& image : drawImages(begin_, end_, samplesPerClass_, rng)) {
+    if (loadedImages_.find(&image.get()) == loadedImages_.end()) {
+      loader_->prefetch(image);
+    }
+  }
+}
+
+void TrainingSet::release(std::vector<TrainingExample>& samples) {
+  std::vector<Image const*> images;
+  std::transform(samples.begin(), samples.end(), std::back_inserter(images),
+                 [](const auto& sample) { return &sample.first.image(); });
+  std::sort(images.begin(), images.end());
+  images.erase(std::unique(images.begin(), images.end()), images.end());
+
+  // Release the images no other sample refers to
+  for (auto image : images) {
+    auto it = loadedImages_.find(image);
+    if (it != loadedImages_.end() && --it->second.samples == 0) {
+      it->second.image.get().release();
+      loadedImages_.erase(it);
+    }
+  }
+}
+
 class TrainSetIteratorImpl
     : public rf::TrainSet<PixelReference>::TrainSetIterator {
  public:
@@ -104,6 +162,96 @@ std::unique_ptr<TrainingSet::TrainSetIterator> TrainingSet::iter() {
 
 TrainingSet::~TrainingSet() {}
 
+void StreamingTrainingSet::sample(rf::Random& rng) {
+  auto images = drawImages(begin_, end_, samplesPerClass_, rng);
+  if (loader_) {
+    for (auto& image : images) {
+      loader_->prefetch(image);
+    }
+  }
+
+  // the same pixels TrainingSet::sample draws, one image loaded at a time
+  chunks_.clear();
+  for (auto& img : images) {
+    auto& image = img.get();
+    if (loader_) {
+      loader_->acquire(image);
+    } else {
+      image.load();
+    }
+
+    auto& chunk = chunks_.emplace_back(Chunk{image, {}, {}, 0});
+    for (const auto& pixel :
+         sampleLabeledPixels(image, samplesPerImage_, rng)) {
+      chunk.pixels.emplace_back(pixel.row(), pixel.col());
+      chunk.labels.push_back(image.getLabelValue(pixel.row(), pixel.col()));
+    }
+    chunk.memory = image.memory();
+
+    image.release();
+  }
+}
+
+rf::Span<const rf::Label> StreamingTrainingSet::labels(size_t chunk) const {
+  return rf::Span<const rf::Label>{chunks_[chunk].labels};
+}
+
+std::vector<TrainingExample> StreamingTrainingSet::load(size_t chunk) {
+  auto const& c = chunks_[chunk];
+  auto& image = c.image.get();
+  if (loader_) {
+    loader_->acquire(image);
+  } else {
+    image.load();
+  }
+
+  std::vector<TrainingExample> samples;
+  samples.reserve(c.pixels.size());
+  for (size_t i = 0; i < c.pixels.size(); ++i) {
+    const auto [row, col] = c.pixels[i];
+    samples.emplace_back(PixelReference{image, row, col}, c.labels[i]);
+  }
+  return samples;
+}
+
+void StreamingTrainingSet::unload(size_t chunk) {
+  chunks_[chunk].image.get().release();
+}
+
+size_t StreamingTrainingSet::chunkMemory(size_t chunk) const {
+  return chunks_[chunk].memory;
+}
+
+void StreamingTrainingSet::prefetch(rf::Random rng) {
+  if (loader_ == nullptr) {
+    return;
+  }
+
+  // the chunk cache of the tree in training loads and releases the images of
+  // the current chunks, sample() queues them again once it is done
+  std::vector<Image const*> current{};
+  for (auto const& chunk : chunks_) {
+    current.push_back(&chunk.image.get());
+  }
+  std::sort(current.begin(), current.end());
+
+  for (auto& image : drawImages(begin_, end_, samplesPerClass_, rng)) {
+    if (!std::binary_search(current.begin(), current.end(), &image.get())) {
+      loader_->prefetch(image);
+    }
+  }
+}
+
+void StreamingTrainingSet::prefetchChunk(size_t chunk) {
+  if (loader_) {
+    loader_->prefetch(chunks_[chunk].image, ImageLoader::Priority::URGENT);
+  }
+}
+
+size_t StreamingTrainingSet::prefetchMemory() const {
+  return loader_ ? loader_->backgroundMemory() : 0;
+}
+
 std::tuple<TrainingSet, TrainingSet, TrainingSet> splitImagePool(
     ImagePool& imagePool, double validationSize, double testSize) {
   // check validationSize and testSize are acceptable
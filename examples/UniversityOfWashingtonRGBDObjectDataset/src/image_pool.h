@@ -1,12 +1,14 @@
 #pragma once
 
 #include <rf/label.h>
+#include <rf/streaming_train_set.h>
 #include <rf/train_set.h>
 
 #include <unordered_map>
 #include <vector>
 
 #include "image.h"
+#include "image_loader.h"
 
 class TrainingSet;
 
@@ -31,7 +33,7 @@ class ImagePool {
   void append(ImageList&& images);
 
   // shuffle the images
-  void shuffle();
+  void shuffle(rf::Random& rng);
 
   [[nodiscard]] size_t size() const noexcept { return pool_.size(); }
 
@@ -60,10 +62,15 @@ class TrainingSet : public rf::TrainSet<PixelReference> {
   size_t size() const noexcept;
   void setSamplesPerClass(size_t n) { samplesPerClass_ = n; }
   void setSamplesPerImage(size_t n) { samplesPerImage_ = n; }
+  // Load the images in the background, and the ones of the next sample
+  // while the trees train
+  void setImageLoader(ImageLoader& loader) { loader_ = &loader; }
 
  public:  // TrainSet
-  std::vector<TrainingExample> sample() override;
+  std::vector<TrainingExample> sample(rf::Random& rng) override;
   std::unique_ptr<TrainSetIterator> iter() override;
+  void release(std::vector<TrainingExample>& samples) override;
+  void prefetch(rf::Random rng) override;
 
   [[nodiscard]] ImageIterator begin() const noexcept { return begin_; }
   [[nodiscard]] ImageIterator end() const noexcept { return end_; }
@@ -73,7 +80,62 @@ class TrainingSet : public rf::TrainSet<PixelReference> {
   size_t samplesPerClass_{0};
   ImageIterator begin_{};
   ImageIterator end_{};
-  std::vector<std::reference_wrapper<LabeledImage>> loadedImages_{};
+  ImageLoader* loader_{nullptr};
+
+  // loaded images and the number of samples referring to them, several
+  // trees can be trained at the same time
+  struct LoadedImage {
+    std::reference_wrapper<LabeledImage> image;
+    size_t samples;
+  };
+  std::unordered_map<Image const*, LoadedImage> loadedImages_{};
+};
+
+/**
+ *
+ *  Streams the images of the pool to rf::RandomForest::train. Only the
+ *  positions and labels of the sampled pixels are kept, every image is a
+ *  chunk loaded while the training needs it.
+ *
+ */
+class StreamingTrainingSet : public rf::StreamingTrainSet<PixelReference> {
+ public:
+  using ImageIterator = ImagePool::ImageIterator;
+
+  StreamingTrainingSet(ImageIterator begin, ImageIterator end) noexcept
+      : begin_{begin}, end_{end} {}
+
+  void setSamplesPerClass(size_t n) { samplesPerClass_ = n; }
+  void setSamplesPerImage(size_t n) { samplesPerImage_ = n; }
+  // Load the images in the background, see TrainingSet::setImageLoader
+  void setImageLoader(ImageLoader& loader) { loader_ = &loader; }
+
+ public:  // StreamingTrainSet
+  void sample(rf::Random& rng) override;
+  [[nodiscard]] size_t chunks() const override { return chunks_.size(); }
+  [[nodiscard]] rf::Span<const rf::Label> labels(
+      size_t chunk) const override;
+  std::vector<TrainingExample> load(size_t chunk) override;
+  void unload(size_t chunk) override;
+  [[nodiscard]] size_t chunkMemory(size_t chunk) const override;
+  void prefetch(rf::Random rng) override;
+  void prefetchChunk(size_t chunk) override;
+  [[nodiscard]] size_t prefetchMemory() const override;
+
+ private:
+  struct Chunk {
+    std::reference_wrapper<LabeledImage> image;
+    std::vector<std::pair<int, int>> pixels;
+    std::vector<rf::Label> labels;
+    size_t memory;
+  };
+
+  size_t samplesPerImage_{0};
+  size_t samplesPerClass_{0};
+  ImageIterator begin_{};
+  ImageIterator end_{};
+  ImageLoader* loader_{nullptr};
+  std::vector<Chunk> chunks_{};
 };
 
 /**
@@ -1,4 +1,7 @@
+#include <rf/codegen.h>
+#include <rf/quantization.h>
 #include <rf/random_forest.h>
+#include <rf/serialization.h>
 
 #include <cassert>
 #include <filesystem>
@@ -8,7 +11,9 @@
 #include <opencv4/opencv2/imgproc.hpp>
 #include <vector>
 
+#include "dense_classifier.h"
 #include "image_pool.h"
+#include "packed_dataset.h"
 #include "pixel_classifier.h"
 
 namespace fs = std::filesystem;
@@ -86,17 +91,45 @@ int main(int argc, char* argv[]) {
   // Image Pool
   ImagePool pool{};
 
-  // gather the images for each class
+  // Decoding the PNG files takes minutes, the first run packs them into a
+  // file that the next runs map instead
+  constexpr auto datasetFile = "dataset.pack";
+
+  // gather the images for each class, registering the labels in the same
+  // order as when the dataset was packed
+  std::vector<LabeledImage> images{};
   for (auto const& entry : imageFolders) {
     auto const& [label, directory] = entry;
-    auto images = findImages(directory, labelRegistry.getLabel(label), bgLabel,
-                             color_suffix, depth_suffix, label_suffix);
+    const auto id = labelRegistry.getLabel(label);
+    auto found = findImages(directory, id, bgLabel, color_suffix, depth_suffix,
+                            label_suffix);
+    images.insert(images.end(), std::make_move_iterator(found.begin()),
+                  std::make_move_iterator(found.end()));
+  }
 
-    pool.append(std::move(images));
+  // pack again if the folders changed since the pack was written, or if it
+  // was written by another version of the example
+  std::vector<LabeledImage> packedImages{};
+  if (fs::exists(datasetFile)) {
+    try {
+      packedImages = loadPackedImages(datasetFile);
+    } catch (std::runtime_error const& e) {
+      std::cout << "Packing the dataset again, " << e.what() << '\n';
+    }
+  }
+  if (!isPackOf(packedImages, images)) {
+    packedImages.clear();
+    packImages(images, datasetFile);
+    packedImages = loadPackedImages(datasetFile);
   }
+  pool.append(std::move(packedImages));
+
+  // Everything random in the example derives from this seed
+  constexpr uint64_t seed = 42;
 
   // Shuffle
-  pool.shuffle();
+  auto rng = rf::Random{seed};
+  pool.shuffle(rng);
 
   // We split the dataset into train, validation and test.
   auto [train, validation, test] = splitImagePool(pool, 0.2, 0.2);
@@ -106,17 +139,46 @@ int main(int argc, char* argv[]) {
   std::cout << "Validation Images: " << validation.size() << '\n';
   std::cout << "Test images:       " << test.size() << '\n';
 
-  // Each iteration of the algorithm it will sample 20 x 50 pixels
-  train.setSamplesPerClass(500);
-  train.setSamplesPerImage(80);
-
-  rf::TreeParameters params;
-  params.numberOfTrees = 10;
-  params.minSamplesPerNode = 20;
-  params.maxDepth = 5;
-  params.candidatesToGeneratePerNode = 1000;
-  rf::RandomForest<PixelClassifier> forest{};
-  forest.train(train, validation, params);
+  // Each tree is trained on 80 pixels of 500 images, streamed from the disk
+  // instead of loading all the images of a tree at once
+  StreamingTrainingSet streamingTrain{train.begin(), train.end()};
+  streamingTrain.setSamplesPerClass(500);
+  streamingTrain.setSamplesPerImage(80);
+
+  // 4 threads decode the images, at most 64 of them ahead of the training
+  ImageLoader loader{4, 64};
+  streamingTrain.setImageLoader(loader);
+
+  // background, apple and banana
+  using Forest =
+      rf::RandomForest<PixelClassifier, rf::DenseLabelDistribution<3>>;
+
+  // Reuse the forest trained by a previous run if there is one
+  constexpr auto forestFile = "forest.rf";
+  Forest forest{};
+  if (fs::exists(forestFile)) {
+    forest = rf::loadForest<PixelClassifier, rf::DenseLabelDistribution<3>>(
+        forestFile);
+  } else {
+    rf::TreeParameters params;
+    params.numberOfTrees = 10;
+    params.minSamplesPerNode = 20;
+    params.maxDepth = 5;
+    params.candidatesToGeneratePerNode = 100;
+    params.seed = seed;
+    // images loaded at the same time while training
+    params.maxSampleMemory = size_t{256} << 20;
+    forest.train(streamingTrain, params);
+    rf::saveForest(forest, forestFile);
+
+    // The same forest as code, for a program that only classifies with it
+    rf::ExportOptions options{};
+    options.namespaceName = "pixel_forest";
+    options.splitType = "PixelClassifier";
+    options.inputType = "PixelReference";
+    options.includes = {"\"pixel_classifier.h\""};
+    rf::exportForest(forest, std::string{"pixel_forest.h"}, options);
+  }
 
   cv::namedWindow("classified");
 
@@ -126,6 +188,9 @@ int main(int argc, char* argv[]) {
       cv::Vec3b{0, 255, 255},  // color bananas yellow
   };
 
+  // classifies whole images on all the hardware threads
+  DenseClassifier<3> classifier{forest};
+
   size_t idx = 0;
   // Show 20 classified images from the test set
   for (auto it = test.begin(); it != test.end() && idx < 20; ++it, ++idx) {
@@ -139,12 +204,11 @@ int main(int argc, char* argv[]) {
     cv::cvtColor(pic, pic, cv::COLOR_RGB2GRAY);
     cv::cvtColor(pic, pic, cv::COLOR_GRAY2RGB);
 
+    const auto classified = classifier.classify(img.getDepth());
+
     for (int row = 0; row < img.rows(); ++row) {
       for (int col = 0; col < img.cols(); ++col) {
-        auto pixel = img.ref(row, col);
-        auto dist = forest.classify(pixel);
-
-        auto label = dist.maxProb().first;
+        auto label = classified.labels.at<uint8_t>(row, col);
 
         if (label != 0) {
           pic.at<cv::Vec3b>(row, col) = colors[label];
@@ -158,9 +222,16 @@ int main(int argc, char* argv[]) {
     img.release();
   }
 
-  // Classification rate
-  std::cout << "\nTest classification error: " << rf::evaluateTree(forest, test)
-            << '\n';
+  // Classification rate, and what storing the forest with 8-bit leaf
+  // probabilities and float16 thresholds costs
+  const auto quantized = rf::quantizeForest<3>(forest);
+  const auto report = rf::compareQuantized(forest, quantized, test);
+  std::cout << "\nTest classification error: " << report.error << '\n';
+  std::cout << "Quantized forest error:    " << report.quantizedError << '\n';
+  std::cout << "Quantized forest size:     " << report.quantizedMemory
+            << " bytes instead of " << report.memory << '\n';
+  std::cout << "Same label on:             " << report.agreement * 100.0
+            << "% of the pixels\n";
 
   return 0;
 }
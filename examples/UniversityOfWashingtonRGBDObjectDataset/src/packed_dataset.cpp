@@ -0,0 +1,259 @@
+#include "packed_dataset.h"
+
+#include <rf/mapped_file.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <opencv4/opencv2/core.hpp>
+#include <opencv4/opencv2/imgcodecs.hpp>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+
+namespace {
+
+size_t alignUp(size_t offset) noexcept {
+  return (offset + packed::kAlignment - 1) / packed::kAlignment *
+         packed::kAlignment;
+}
+
+cv::Mat readImage(fs::path const& path) {
+  auto img =
+      cv::imread(path.string(), cv::IMREAD_ANYDEPTH | cv::IMREAD_ANYCOLOR);
+  if (img.empty()) {
+    throw std::runtime_error("cannot read image " + path.string());
+  }
+  return img;
+}
+
+class Writer {
+ public:
+  explicit Writer(std::string const& path)
+      : os_{path, std::ios::binary | std::ios::trunc} {
+    check();
+  }
+
+  [[nodiscard]] size_t offset() const noexcept { return offset_; }
+
+  void write(void const* data, size_t size) {
+    os_.write(static_cast<char const*>(data),
+              static_cast<std::streamsize>(size));
+    offset_ += size;
+    check();
+  }
+
+  void align() {
+    static constexpr char zeros[packed::kAlignment] = {};
+    write(zeros, alignUp(offset_) - offset_);
+  }
+
+  // Rows of the image one after the other, whatever the matrix step is
+  void writeRows(cv::Mat const& img, size_t rowSize) {
+    for (int row = 0; row < img.rows; ++row) {
+      write(img.ptr(row), rowSize);
+    }
+  }
+
+  // Padded buffer of a float image, see depthLayout()
+  void writePadded(cv::Mat const& img) {
+    const auto layout = depthLayout(img.rows, img.cols);
+    const std::vector<float> zeros(layout.stride, 0.0f);
+    const auto side = kDepthPadding * sizeof(float);
+    const auto row = layout.stride * sizeof(float);
+    write(zeros.data(), side);
+    for (int i = 0; i < kDepthPadding; ++i) {
+      write(zeros.data(), row);
+    }
+    for (int i = 0; i < img.rows; ++i) {
+      write(img.ptr(i), img.cols * sizeof(float));
+      write(zeros.data(), side);
+    }
+    for (int i = 0; i < kDepthPadding; ++i) {
+      write(zeros.data(), row);
+    }
+  }
+
+  void rewind() {
+    os_.seekp(0);
+    offset_ = 0;
+    check();
+  }
+
+  void close() {
+    os_.close();
+    check();
+  }
+
+ private:
+  void check() {
+    if (!os_) {
+      throw std::runtime_error("cannot write the packed dataset");
+    }
+  }
+
+  std::ofstream os_;
+  size_t offset_{0};
+};
+
+}  // namespace
+
+namespace {
+
+void writePack(std::vector<LabeledImage> const& images,
+               std::string const& path) {
+  packed::FileHeader header{};
+  std::memcpy(header.magic, packed::kMagic, sizeof(header.magic));
+  header.version = packed::kVersion;
+  header.byteOrder = packed::kByteOrder;
+  header.depthPadding = kDepthPadding;
+  header.imageCount = images.size();
+
+  std::vector<packed::ImageEntry> entries(images.size());
+  std::vector<std::string> paths{};
+
+  Writer writer{path};
+  // the index is written again once the offsets are known
+  writer.write(&header, sizeof(header));
+  writer.write(entries.data(), entries.size() * sizeof(packed::ImageEntry));
+
+  for (size_t i = 0; i < images.size(); ++i) {
+    const auto color = images[i].getColorPath().string();
+    entries[i].pathOffset = writer.offset();
+    entries[i].pathSize = static_cast<uint32_t>(color.size());
+    writer.write(color.data(), color.size());
+  }
+
+  for (size_t i = 0; i < images.size(); ++i) {
+    auto& entry = entries[i];
+
+    // same conversions as the image handlers
+    auto depth = readImage(images[i].getDepthPath());
+    depth.convertTo(depth, CV_32F);
+    auto mask = readImage(images[i].getLabelPath());
+    if (mask.type() != CV_8UC1 || mask.rows != depth.rows ||
+        mask.cols != depth.cols) {
+      throw std::runtime_error("unexpected label image " +
+                               images[i].getLabelPath().string());
+    }
+
+    entry.rows = depth.rows;
+    entry.cols = depth.cols;
+    entry.label = images[i].label();
+    entry.bgLabel = images[i].bgLabel();
+
+    writer.align();
+    entry.depthOffset = writer.offset();
+    writer.writePadded(depth);
+
+    writer.align();
+    entry.maskOffset = writer.offset();
+    writer.writeRows(mask, mask.cols * sizeof(uint8_t));
+  }
+
+  writer.rewind();
+  writer.write(&header, sizeof(header));
+  writer.write(entries.data(), entries.size() * sizeof(packed::ImageEntry));
+  writer.close();
+}
+
+}  // namespace
+
+void packImages(std::vector<LabeledImage> const& images,
+                std::string const& path) {
+  // the index is only valid once every image is written, a pack that failed
+  // half way must not be found by the next run
+  const auto partial = path + ".partial";
+  try {
+    writePack(images, partial);
+    fs::rename(partial, path);
+  } catch (...) {
+    std::error_code ignored{};
+    fs::remove(partial, ignored);
+    throw;
+  }
+}
+
+bool isPackOf(std::vector<LabeledImage> const& packedImages,
+              std::vector<LabeledImage> const& images) {
+  using Key = std::tuple<std::string, rf::Label, rf::Label>;
+  auto keys = [](std::vector<LabeledImage> const& list) {
+    std::vector<Key> keys{};
+    for (auto const& image : list) {
+      keys.emplace_back(image.getColorPath().string(), image.label(),
+                        image.bgLabel());
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+  };
+  return keys(packedImages) == keys(images);
+}
+
+std::vector<LabeledImage> loadPackedImages(std::string const& path) {
+  auto file = std::make_shared<const rf::MappedFile>(path);
+  auto const* data = file->data();
+  const auto size = file->size();
+
+  auto invalid = [&path](char const* what) {
+    return std::runtime_error(path + ": " + what);
+  };
+
+  packed::FileHeader header{};
+  if (size < sizeof(header)) {
+    throw invalid("too small to be a packed dataset");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, packed::kMagic, sizeof(header.magic)) != 0) {
+    throw invalid("not a packed dataset");
+  }
+  if (header.version != packed::kVersion ||
+      header.byteOrder != packed::kByteOrder ||
+      header.depthPadding != static_cast<uint32_t>(kDepthPadding)) {
+    throw invalid("incompatible packed dataset");
+  }
+  if (header.imageCount >
+      (size - sizeof(header)) / sizeof(packed::ImageEntry)) {
+    throw invalid("truncated index");
+  }
+
+  // checked against the file size without overflowing
+  auto fits = [size](uint64_t offset, uint64_t bytes) {
+    return offset <= size && bytes <= size - offset;
+  };
+
+  std::vector<LabeledImage> images{};
+  images.reserve(header.imageCount);
+  for (size_t i = 0; i < header.imageCount; ++i) {
+    packed::ImageEntry entry{};
+    std::memcpy(&entry,
+                data + sizeof(header) + i * sizeof(packed::ImageEntry),
+                sizeof(entry));
+
+    const auto rows = static_cast<uint64_t>(std::max(entry.rows, 0));
+    const auto cols = static_cast<uint64_t>(std::max(entry.cols, 0));
+    const auto layout = depthLayout(rows, cols);
+    if (entry.rows <= 0 || entry.cols <= 0 ||
+        entry.depthOffset % alignof(float) != 0 ||
+        !fits(entry.pathOffset, entry.pathSize) ||
+        !fits(entry.depthOffset, layout.size * sizeof(float)) ||
+        !fits(entry.maskOffset, rows * cols)) {
+      throw invalid("corrupted image entry");
+    }
+
+    DecodedImage image{};
+    image.color = std::string{
+        reinterpret_cast<char const*>(data + entry.pathOffset),
+        entry.pathSize};
+    image.rows = entry.rows;
+    image.cols = entry.cols;
+    image.depth = reinterpret_cast<float const*>(data + entry.depthOffset) +
+                  layout.origin;
+    image.depthStride = static_cast<ptrdiff_t>(layout.stride);
+    image.mask = reinterpret_cast<uint8_t const*>(data + entry.maskOffset);
+    image.storage = file;
+    images.emplace_back(image, entry.label, entry.bgLabel);
+  }
+
+  return images;
+}
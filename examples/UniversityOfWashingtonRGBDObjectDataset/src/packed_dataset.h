@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image.h"
+
+/**
+ *
+ *  Binary file of a dataset already decoded, so the PNG files are decoded
+ *  once instead of every run.
+ *
+ *  The file starts with a FileHeader and one ImageEntry per image, followed
+ *  by the paths of the color images. The depth, as float and padded with
+ *  `depthPadding` zeros as depthLayout() describes, and the mask of every
+ *  image are then stored row after row, each block starting at a multiple of
+ *  kAlignment, so that the images use the mapped file in place.
+ *
+ *  The labels are the ids given by rf::LabelRegistry when packing, the
+ *  program loading the file has to register them in the same order.
+ *
+ */
+namespace packed {
+
+constexpr char kMagic[8] = {'R', 'G', 'B', 'D', '-', 'D', 'S', '\0'};
+constexpr uint32_t kVersion = 3;
+constexpr uint32_t kByteOrder = 0x01020304;
+constexpr size_t kAlignment = 64;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  // kDepthPadding of the program that packed the images
+  uint32_t depthPadding;
+  uint32_t reserved;
+  uint64_t imageCount;
+};
+
+struct ImageEntry {
+  // start of the padded depth buffer
+  uint64_t depthOffset;
+  uint64_t maskOffset;
+  uint64_t pathOffset;
+  uint32_t pathSize;
+  int32_t rows;
+  int32_t cols;
+  uint8_t label;
+  uint8_t bgLabel;
+  uint16_t reserved;
+};
+
+}  // namespace packed
+
+/**
+ *
+ *  Decode the images and write them to a packed dataset file, one image at a
+ *  time. The file is written next to `path` and renamed once complete, so
+ *  `path` is either a whole pack or left as it was. Throws
+ *  std::runtime_error if an image or the file cannot be read or written.
+ *
+ */
+void packImages(std::vector<LabeledImage> const& images,
+                std::string const& path);
+
+/**
+ *
+ *  Map a packed dataset file. Nothing is decoded or copied, the images read
+ *  the mapped file and keep it mapped for as long as any of them is alive.
+ *
+ *  Throws std::system_error if the file cannot be mapped and
+ *  std::runtime_error if it is not a packed dataset.
+ *
+ */
+std::vector<LabeledImage> loadPackedImages(std::string const& path);
+
+/**
+ *
+ *  Whether a loaded pack holds the same images, with the same labels, as
+ *  found in the image folders, in any order.
+ *
+ */
+bool isPackOf(std::vector<LabeledImage> const& packedImages,
+              std::vector<LabeledImage> const& images);
@@ -1,61 +1,175 @@
 #pragma once
 
-#include <rf/split_candidate.h>
+#include <rf/codegen.h>
+#include <rf/feature_response.h>
+#include <rf/half.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
 #include <random>
 
 #include "image.h"
 
-using PixelOffset = std::pair<int, int>;
+/**
+ *  Plain struct instead of std::pair, the classifier has to be trivially
+ *  copyable to be saved
+ */
+struct PixelOffset {
+  int first{0};
+  int second{0};
+};
+
+/**
+ *  Ratio of the depth differences between two pixels, `offset1` and
+ *  `offset2` floats away from `center`, and the center itself
+ */
+inline float depthRatio(float const* center, ptrdiff_t offset1,
+                        ptrdiff_t offset2) noexcept {
+  const double centerDepth = *center;
+  const double offset1Depth = center[offset1];
+  const double offset2Depth = center[offset2];
+
+  return static_cast<float>((offset1Depth - centerDepth) /
+                            (offset2Depth - centerDepth));
+}
+
+/**
+ *  PixelClassifier with 8-bit offsets and a float16 threshold, 6 bytes
+ *  instead of 20. The offsets fit since they are within kDepthPadding.
+ */
+class QuantizedPixelClassifier
+    : public rf::SplitCandidate<QuantizedPixelClassifier, PixelReference> {
+  static_assert(kDepthPadding <= INT8_MAX, "offsets must fit in int8_t");
 
-class PixelClassifier
-    : public rf::SplitCandidate<PixelClassifier, PixelReference> {
  public:
   rf::SplitResult classify(PixelReference const& p) const noexcept {
-    using PixelCoord = std::pair<int, int>;
-    PixelCoord center = std::make_pair(p.row(), p.col());
-    PixelCoord offset1 =
-        std::make_pair(p.row() + o1_.first, p.col() + o1_.second);
-    PixelCoord offset2 =
-        std::make_pair(p.row() + o2_.first, p.col() + o2_.second);
+    auto const& depth = p.image().depth();
+    const auto stride = depth.stride;
+    const auto response =
+        depthRatio(depth.at(p.row(), p.col()), o1_[0] * stride + o1_[1],
+                   o2_[0] * stride + o2_[1]);
+    return response < threshold_.toFloat() ? rf::SplitResult::LEFT
+                                           : rf::SplitResult::RIGHT;
+  }
+
+  static constexpr uint32_t serializationVersion() noexcept { return 1; }
 
-    auto const& image = p.image();
-    const auto centerDepth = image.getDepthValue(center.first, center.second);
-    const auto offset1Depth =
-        image.getDepthValue(offset1.first, offset1.second);
-    const auto offset2Depth =
-        image.getDepthValue(offset2.first, offset2.second);
+  // the depth is read unchecked, as far as kDepthPadding
+  [[nodiscard]] bool valid() const noexcept {
+    return std::max({std::abs(o1_[0]), std::abs(o1_[1]), std::abs(o2_[0]),
+                     std::abs(o2_[1])}) <= kDepthPadding;
+  }
+
+  QuantizedPixelClassifier() = default;
+  QuantizedPixelClassifier(PixelOffset o1, PixelOffset o2,
+                           rf::Half threshold) noexcept
+      : o1_{static_cast<int8_t>(o1.first), static_cast<int8_t>(o1.second)},
+        o2_{static_cast<int8_t>(o2.first), static_cast<int8_t>(o2.second)},
+        threshold_{threshold} {}
 
-    const auto ratio =
-        (offset1Depth - centerDepth) / (offset2Depth - centerDepth);
+ private:
+  int8_t o1_[2]{};
+  int8_t o2_[2]{};
+  rf::Half threshold_{};
+};
 
-    return ratio < t_ ? rf::SplitResult::LEFT : rf::SplitResult::RIGHT;
+/**
+ *  Depth comparison feature: ratio of the depth differences between two
+ *  offsets and the pixel, compared against the threshold
+ */
+class PixelClassifier
+    : public rf::FeatureResponse<PixelClassifier, PixelReference> {
+ public:
+  float response(PixelReference const& p) const noexcept {
+    auto const& depth = p.image().depth();
+    return response(depth.at(p.row(), p.col()), depth.stride);
   }
 
-  static PixelClassifier generate() {
-    std::random_device rd{};
-    std::mt19937 gen{rd()};
+  /**
+   *  Same response read from a depth buffer, `center` points to the pixel
+   *  and rows are `stride` floats apart. The buffer has to extend
+   *  maxOffset() pixels around the pixel, it is not checked.
+   */
+  float response(float const* center, ptrdiff_t stride) const noexcept {
+    return depthRatio(center, o1_.first * stride + o1_.second,
+                      o2_.first * stride + o2_.second);
+  }
 
+  using FeatureResponse::classify;
+  rf::SplitResult classify(float const* center,
+                           ptrdiff_t stride) const noexcept {
+    return response(center, stride) < threshold() ? rf::SplitResult::LEFT
+                                                  : rf::SplitResult::RIGHT;
+  }
+
+  /**
+   *  Largest distance, in rows or columns, from the pixel to the depth
+   *  values the response reads.
+   */
+  [[nodiscard]] int maxOffset() const noexcept {
+    return std::max({std::abs(o1_.first), std::abs(o1_.second),
+                     std::abs(o2_.first), std::abs(o2_.second)});
+  }
+
+  static PixelClassifier generate(rf::Random& gen) {
     // notice the images in this set are about ~80x80 pixels
     // here we choose a standard deviations of just half of that
     // this can be better thought
     std::normal_distribution<double> offsetDist{0, 40};
-    std::normal_distribution<double> threshDist{0.5, 0.25};
+    std::normal_distribution<float> threshDist{0.5f, 0.25f};
 
-    auto offset1 = std::make_pair(std::round(offsetDist(gen)),
-                                  std::round(offsetDist(gen)));
-    auto offset2 = std::make_pair(std::round(offsetDist(gen)),
-                                  std::round(offsetDist(gen)));
+    // the depth is read unchecked as far as kDepthPadding, offsets beyond it
+    // (about one draw in nine) are drawn again. Clamping them would move the
+    // pixel they read.
+    auto offset = [&]() {
+      while (true) {
+        const auto o = static_cast<int>(std::round(offsetDist(gen)));
+        if (std::abs(o) <= kDepthPadding) {
+          return o;
+        }
+      }
+    };
+    auto offset1 = PixelOffset{offset(), offset()};
+    auto offset2 = PixelOffset{offset(), offset()};
 
     return PixelClassifier(offset1, offset2, threshDist(gen));
   }
 
+  static constexpr uint32_t serializationVersion() noexcept { return 3; }
+
+  // the depth is read unchecked, as far as kDepthPadding
+  [[nodiscard]] bool valid() const noexcept {
+    return maxOffset() <= kDepthPadding;
+  }
+
+  // for rf::quantizeForest
+  QuantizedPixelClassifier quantize() const noexcept {
+    return QuantizedPixelClassifier{o1_, o2_, rf::Half{threshold()}};
+  }
+
+  // constructor expression, for rf::exportForest
+  void writeSource(std::ostream& os) const {
+    os << "PixelClassifier{PixelOffset{" << o1_.first << ", " << o1_.second
+       << "}, PixelOffset{" << o2_.first << ", " << o2_.second << "}, ";
+    rf::writeLiteral(os, threshold());
+    os << '}';
+  }
+
   PixelClassifier() = default;
-  explicit PixelClassifier(PixelOffset o1, PixelOffset o2, double t) noexcept
-      : o1_{o1}, o2_{o2}, t_{t} {}
+  // The depth is read unchecked, offsets beyond kDepthPadding are clamped.
+  // generate() never draws them.
+  explicit PixelClassifier(PixelOffset o1, PixelOffset o2, float t) noexcept
+      : FeatureResponse{t}, o1_{clamp(o1)}, o2_{clamp(o2)} {}
 
  private:
+  static PixelOffset clamp(PixelOffset o) noexcept {
+    return {std::clamp(o.first, -kDepthPadding, kDepthPadding),
+            std::clamp(o.second, -kDepthPadding, kDepthPadding)};
+  }
+
   PixelOffset o1_{};
   PixelOffset o2_{};
-  double t_{0.0};
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rf {
+
+/**
+ *  Monotonic allocator for the nodes of a tree.
+ *
+ *  Objects are placed one after the other in large blocks that are only
+ *  freed when the arena is destroyed. Destroying the arena only runs the
+ *  destructors of the objects that have one, so a tree of trivially
+ *  destructible nodes is freed with a handful of deallocations.
+ *
+ *  It can be used from several threads at the same time.
+ */
+class Arena {
+ public:
+  /**
+   *  The first block has `initialSize` bytes, the next ones grow
+   *  geometrically.
+   */
+  explicit Arena(size_t initialSize = 64 * 1024);
+  ~Arena();
+
+  Arena(Arena const&) = delete;
+  Arena& operator=(Arena const&) = delete;
+
+  [[nodiscard]] void* allocate(size_t size, size_t alignment);
+
+  template <typename T, typename... Args>
+  T* create(Args&&... args) {
+    auto object = new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      addDestructor(object, [](void* p) { static_cast<T*>(p)->~T(); });
+    }
+    return object;
+  }
+
+ private:
+  using Destructor = void (*)(void*);
+  void addDestructor(void* object, Destructor destructor);
+
+  std::mutex mutex_{};
+  std::pmr::monotonic_buffer_resource memory_;
+  std::vector<std::pair<void*, Destructor>> destructors_{};
+};
+
+}  // namespace rf
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <rf/random_forest.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace rf {
+
+/**
+ *  Names the generated source refers to, it cannot guess them from the
+ *  template arguments.
+ */
+struct ExportOptions {
+  // namespace the generated functions and tables are put in
+  std::string namespaceName{"forest"};
+  // fully qualified SplitCandidate and SplitCandidate::Input, both required
+  std::string splitType{};
+  std::string inputType{};
+  // headers declaring them, written as `#include <...>` or `#include "..."`
+  std::vector<std::string> includes{};
+};
+
+/**
+ *  Write a trained forest as a C++ header, to be compiled into a program
+ *  that always evaluates the same model.
+ *
+ *  Every tree becomes a function of nested if/else on the split candidates,
+ *  constructed in place so the compiler sees their parameters as constants
+ *  and inlines their classify(). It returns the leaf index, the leaf
+ *  probabilities are kept in a constant table. The generated header
+ *  declares, in the requested namespace:
+ *
+ *  - `kNumberOfTrees` and `kNumberOfLabels`
+ *  - `uint32_t treeN(Input const&)` for every tree
+ *  - `void classify(Input const&, double* scores)`, the probability of
+ *    every label combined as RandomForest::classifyBatch() does
+ *  - `rf::Label predict(Input const&)`, the label with the highest one
+ *
+ *  A split candidate spells itself with an optional member
+ *  `void writeSource(std::ostream&) const` writing an expression that
+ *  constructs an equal candidate, writeLiteral() helps keeping the floating
+ *  point parameters exact. Candidates without it are rebuilt from their
+ *  bytes, which requires them to be trivially copyable and the generated
+ *  code to run on a machine with the same byte order. The header checks
+ *  SplitCandidate::serializationVersion() when compiled.
+ *
+ *  Throws std::invalid_argument if a type name is missing and
+ *  std::runtime_error if the stream fails.
+ */
+template <typename SplitCandidate, typename Distribution>
+void exportForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                  std::ostream& os, ExportOptions const& options);
+
+template <typename SplitCandidate, typename Distribution>
+void exportForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                  std::string const& path, ExportOptions const& options);
+
+/**
+ *  Write a literal of exactly the same value, in hexadecimal notation.
+ */
+void writeLiteral(std::ostream& os, float value);
+void writeLiteral(std::ostream& os, double value);
+
+}  // namespace rf
+
+#include "impl/codegen.hpp"
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <rf/label.h>
+
+#include <array>
+#include <utility>
+
+namespace rf {
+
+/**
+ *  Label distribution for problems with at most `NumLabels` labels.
+ *
+ *  It offers the same interface as LabelDistribution but the probabilities
+ *  are stored in a fixed array indexed by label. It does not allocate, copies
+ *  are a memcpy and combining two distributions is a plain loop over the
+ *  array.
+ */
+template <size_t NumLabels>
+class DenseLabelDistribution {
+  static_assert(NumLabels > 0, "a distribution needs at least one label");
+
+ public:
+  DenseLabelDistribution() = default;
+
+  /**
+   *  Convenient constructor to get a Label distribution from a sequence of
+   *  labels. Labels not smaller than NumLabels are ignored.
+   */
+  template <typename InputIterator>
+  DenseLabelDistribution(InputIterator begin, InputIterator end);
+
+  /**
+   *  Combine label distributions is performed to merge the votes from every
+   *  tree in the forest
+   */
+  DenseLabelDistribution& combine(DenseLabelDistribution const& other) noexcept;
+
+  /**
+   *  Compute and return the entropy level for the distribution.
+   */
+  [[nodiscard]] double entropy() const noexcept;
+
+  /**
+   *  Return the <label, prob> pair with max probability.
+   */
+  [[nodiscard]] std::pair<Label, double> maxProb() const noexcept {
+    return {maxLabel_, maxProb_};
+  }
+
+  [[nodiscard]] double probability(Label label) const noexcept {
+    return label < NumLabels ? prob_[label] : 0.0;
+  }
+
+  /**
+   *  Call `f(label, probability)` for every label in the distribution.
+   */
+  template <typename Function>
+  void forEach(Function&& f) const {
+    for (size_t i = 0; i < NumLabels; ++i) {
+      f(static_cast<Label>(i), prob_[i]);
+    }
+  }
+
+  [[nodiscard]] static constexpr size_t size() noexcept { return NumLabels; }
+
+ private:
+  void normalize(double total) noexcept;
+  void updateMaxProb() noexcept;
+
+  std::array<double, NumLabels> prob_{};
+  Label maxLabel_{0};
+  double maxProb_{0.0};
+};
+
+}  // namespace rf
+
+#include "impl/dense_label_distribution.hpp"
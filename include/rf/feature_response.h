@@ -0,0 +1,68 @@
+#pragma once
+
+#include <rf/split_candidate.h>
+
+#include <type_traits>
+#include <utility>
+
+namespace rf {
+
+/**
+ *  Split candidate that compares a scalar response of the data against a
+ *  threshold: samples with a response below the threshold go to the left.
+ *
+ *  Derived classes implement `float response(Data const&) const noexcept`
+ *  instead of `classify`. The training computes the responses of all the
+ *  samples of a node into a contiguous array once per generated candidate
+ *  and scores its thresholds on that array, see
+ *  TreeParameters::thresholdsPerFeature. The extra thresholds are the
+ *  responses of random samples of the node.
+ */
+template <typename Derived, typename Data>
+class FeatureResponse : public SplitCandidate<Derived, Data> {
+ public:
+  [[nodiscard]] SplitResult classify(Data const& d) const noexcept {
+    return derived().response(d) < threshold_ ? SplitResult::LEFT
+                                              : SplitResult::RIGHT;
+  }
+
+  /**
+   *  Write the responses of the training examples in [begin, end) to `out`.
+   *  Derived classes can provide a faster version for a whole batch.
+   */
+  template <typename InputIterator>
+  void responses(InputIterator begin, InputIterator end,
+                 float* out) const noexcept {
+    for (auto it = begin; it != end; ++it) {
+      *out++ = derived().response(it->first);
+    }
+  }
+
+  [[nodiscard]] float threshold() const noexcept { return threshold_; }
+  void setThreshold(float threshold) noexcept { threshold_ = threshold; }
+
+ protected:
+  FeatureResponse() = default;
+  explicit FeatureResponse(float threshold) noexcept : threshold_{threshold} {}
+
+ private:
+  [[nodiscard]] Derived const& derived() const noexcept {
+    return static_cast<Derived const&>(*this);
+  }
+
+  float threshold_{0.0f};
+};
+
+namespace impl {
+
+template <typename Derived, typename Data>
+std::true_type derivesFeatureResponse(FeatureResponse<Derived, Data> const*);
+std::false_type derivesFeatureResponse(...);
+
+}  // namespace impl
+
+template <typename SplitCandidate>
+constexpr bool isFeatureResponse = decltype(impl::derivesFeatureResponse(
+    std::declval<SplitCandidate const*>()))::value;
+
+}  // namespace rf
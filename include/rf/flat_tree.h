@@ -0,0 +1,103 @@
+#pragma once
+
+#include <rf/span.h>
+#include <rf/tree.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rf {
+
+/**
+ *  Inference only representation of a trained Tree.
+ *
+ *  The split nodes are stored in breadth-first order in a single array, each
+ *  one holding its split candidate and the index of its children inline. The
+ *  leaf distributions are packed in a separate array. Classifying walks the
+ *  array in a loop, there are no pointers to follow and no virtual calls.
+ *
+ *  A child index with the kLeaf bit set refers to the leaf array.
+ *
+ *  The tree does not modify its arrays after construction. It either owns
+ *  them or views memory kept alive by a shared owner, e.g. a memory-mapped
+ *  file. Copies share the arrays.
+ */
+template <typename SplitCandidate, typename Distribution = LabelDistribution>
+class FlatTree {
+ public:
+  using Data = typename SplitCandidate::Input;
+  using Index = uint32_t;
+
+  static constexpr Index kLeaf = Index{1} << 31;
+  // inputs descending the tree together in leafIndices()
+  static constexpr size_t kInterleave = 8;
+
+  struct Node {
+    SplitCandidate split{};
+    // indexed by SplitResult
+    Index children[2]{kLeaf, kLeaf};
+  };
+
+  FlatTree() = default;
+  FlatTree(std::vector<Node>&& nodes, std::vector<Distribution>&& leaves,
+           Index root);
+
+  /**
+   *  View arrays owned by someone else, `owner` keeps them alive.
+   */
+  FlatTree(Span<const Node> nodes, Span<const Distribution> leaves, Index root,
+           std::shared_ptr<const void> owner) noexcept
+      : nodes_{nodes}, leaves_{leaves}, root_{root}, owner_{std::move(owner)} {}
+
+  [[nodiscard]] Distribution const& classify(Data const& data) const noexcept {
+    return leaves_[leafIndex(data)];
+  }
+
+  /**
+   *  Index in leaves() of the leaf the data falls into.
+   */
+  [[nodiscard]] Index leafIndex(Data const& data) const noexcept {
+    auto index = root_;
+    while (!(index & kLeaf)) {
+      auto const& node = nodes_[index];
+      index = node.children[static_cast<size_t>(node.split.classify(data))];
+    }
+    return index & ~kLeaf;
+  }
+
+  /**
+   *  Index in leaves() of the leaf of every input, `out` must have the same
+   *  size as `data`.
+   *
+   *  Groups of kInterleave inputs descend the tree in lock-step: each step
+   *  evaluates the nodes of the whole group, whose loads do not depend on
+   *  each other and overlap, and prefetches the nodes they go to next. The
+   *  result is the same as leafIndex() on every input.
+   */
+  void leafIndices(Span<const Data> data, Span<Index> out) const noexcept;
+
+  [[nodiscard]] Span<const Node> nodes() const noexcept { return nodes_; }
+  [[nodiscard]] Span<const Distribution> leaves() const noexcept {
+    return leaves_;
+  }
+  [[nodiscard]] Index root() const noexcept { return root_; }
+
+ private:
+  Span<const Node> nodes_{};
+  Span<const Distribution> leaves_{};
+  Index root_{kLeaf};
+  std::shared_ptr<const void> owner_{nullptr};
+};
+
+/**
+ *  Compile a trained tree into its flat representation. SplitCandidate must
+ *  be the candidate the tree was trained with.
+ */
+template <typename SplitCandidate, typename Data, typename Distribution>
+FlatTree<SplitCandidate, Distribution> compileTree(
+    Tree<Data, Distribution> const& tree);
+
+}  // namespace rf
+
+#include "impl/flat_tree.hpp"
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace rf {
+
+/**
+ *  IEEE 754 half precision number, for storage only: it converts to and
+ *  from float and has no arithmetic. Conversions from float round to the
+ *  nearest value, ties to even, and overflow to infinity.
+ */
+class Half {
+ public:
+  Half() = default;
+  explicit Half(float value) noexcept : bits_{fromFloat(value)} {}
+
+  [[nodiscard]] float toFloat() const noexcept {
+    const uint32_t sign = uint32_t{bits_ & 0x8000u} << 16;
+    const uint32_t exponent = (bits_ >> 10) & 0x1fu;
+    const uint32_t mantissa = bits_ & 0x3ffu;
+
+    uint32_t bits = 0;
+    if (exponent == 0) {
+      // zero and subnormals are mantissa * 2^-24, exact as a float
+      const float value = static_cast<float>(mantissa) * 0x1p-24f;
+      std::memcpy(&bits, &value, sizeof(bits));
+    } else if (exponent == 0x1f) {
+      bits = 0x7f800000u | (mantissa << 13);
+    } else {
+      bits = ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float value = 0.0f;
+    bits |= sign;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  [[nodiscard]] uint16_t bits() const noexcept { return bits_; }
+
+ private:
+  static uint16_t fromFloat(float value) noexcept;
+
+  uint16_t bits_{0};
+};
+
+}  // namespace rf
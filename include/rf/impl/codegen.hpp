@@ -0,0 +1,194 @@
+#include <rf/codegen.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace rf {
+namespace impl {
+
+template <typename SplitCandidate>
+using WriteSource = decltype(std::declval<SplitCandidate const&>().writeSource(
+    std::declval<std::ostream&>()));
+
+template <typename SplitCandidate, typename = void>
+struct HasWriteSource : std::false_type {};
+
+template <typename SplitCandidate>
+struct HasWriteSource<SplitCandidate, std::void_t<WriteSource<SplitCandidate>>>
+    : std::true_type {};
+
+template <typename SplitCandidate>
+void writeSplit(std::ostream& os, SplitCandidate const& split) {
+  if constexpr (HasWriteSource<SplitCandidate>::value) {
+    split.writeSource(os);
+  } else {
+    static_assert(std::is_trivially_copyable_v<SplitCandidate>,
+                  "split candidates without writeSource() are exported as "
+                  "bytes and must be trivially copyable");
+
+    // octal escapes, hexadecimal ones would swallow the digits after them
+    char bytes[sizeof(SplitCandidate)];
+    std::memcpy(bytes, &split, sizeof(bytes));
+    os << "splitFromBytes(\"";
+    for (auto byte : bytes) {
+      const auto value = static_cast<unsigned char>(byte);
+      os << '\\' << static_cast<char>('0' + (value >> 6))
+         << static_cast<char>('0' + ((value >> 3) & 7))
+         << static_cast<char>('0' + (value & 7));
+    }
+    os << "\")";
+  }
+}
+
+/**
+ *  The subtree of `index` as the body of the tree function, one nesting
+ *  level per depth.
+ */
+template <typename SplitCandidate, typename Distribution>
+void writeSubtree(std::ostream& os,
+                  FlatTree<SplitCandidate, Distribution> const& tree,
+                  uint32_t index, size_t depth) {
+  using Tree = FlatTree<SplitCandidate, Distribution>;
+
+  const std::string indent(2 * depth, ' ');
+  if (index & Tree::kLeaf) {
+    os << indent << "return " << (index & ~Tree::kLeaf) << ";\n";
+    return;
+  }
+
+  auto const& node = tree.nodes()[index];
+  os << indent << "if (";
+  writeSplit(os, node.split);
+  os << ".classify(x) == rf::SplitResult::LEFT) {\n";
+  writeSubtree(os, tree, node.children[0], depth + 1);
+  os << indent << "} else {\n";
+  writeSubtree(os, tree, node.children[1], depth + 1);
+  os << indent << "}\n";
+}
+
+}  // namespace impl
+
+template <typename SplitCandidate, typename Distribution>
+void exportForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                  std::ostream& os, ExportOptions const& options) {
+  if (options.splitType.empty() || options.inputType.empty()) {
+    throw std::invalid_argument("the split and input types must be named");
+  }
+
+  auto const& trees = forest.trees();
+  const auto labels = forest.numberOfLabels();
+  if (trees.empty() || labels == 0) {
+    throw std::invalid_argument("cannot export an empty forest");
+  }
+
+  os << "// Generated by rf::exportForest, do not edit.\n"
+        "#pragma once\n\n"
+        "#include <rf/label.h>\n"
+        "#include <rf/split_candidate.h>\n\n"
+        "#include <cstddef>\n"
+        "#include <cstdint>\n"
+        "#include <cstring>\n"
+        "#include <limits>\n\n";
+  for (auto const& include : options.includes) {
+    os << "#include " << include << '\n';
+  }
+
+  os << "\nnamespace " << options.namespaceName << " {\n\n"
+     << "using Split = " << options.splitType << ";\n"
+     << "using Input = " << options.inputType << ";\n\n"
+     << "static_assert(Split::serializationVersion() == "
+     << SplitCandidate::serializationVersion()
+     << ",\n              \"exported with another version of the split "
+        "candidate\");\n\n"
+     << "inline constexpr size_t kNumberOfTrees = " << trees.size() << ";\n"
+     << "inline constexpr size_t kNumberOfLabels = " << labels << ";\n\n";
+
+  if constexpr (!impl::HasWriteSource<SplitCandidate>::value) {
+    os << "static_assert(sizeof(Split) == " << sizeof(SplitCandidate)
+       << ", \"exported with another split candidate\");\n\n"
+       << "inline Split splitFromBytes(char const* bytes) noexcept {\n"
+          "  Split split{};\n"
+          "  std::memcpy(static_cast<void*>(&split), bytes, sizeof(split));\n"
+          "  return split;\n"
+          "}\n\n";
+  }
+
+  for (size_t t = 0; t < trees.size(); ++t) {
+    auto const& tree = trees[t];
+
+    // one row of probabilities per leaf
+    os << "inline constexpr double kTree" << t << "Leaves["
+       << tree.leaves().size() << "][" << labels << "] = {\n";
+    std::vector<double> row(labels);
+    for (auto const& leaf : tree.leaves()) {
+      std::fill(row.begin(), row.end(), 0.0);
+      leaf.forEach([&row, labels](Label label, double p) {
+        if (label < labels) {
+          row[label] = p;
+        }
+      });
+
+      os << "    {";
+      for (size_t l = 0; l < labels; ++l) {
+        os << (l == 0 ? "" : ", ");
+        writeLiteral(os, row[l]);
+      }
+      os << "},\n";
+    }
+    os << "};\n\n";
+
+    os << "inline uint32_t tree" << t
+       << "([[maybe_unused]] Input const& x) noexcept {\n";
+    impl::writeSubtree(os, tree, tree.root(), 1);
+    os << "}\n\n";
+  }
+
+  // same combination as RandomForest::classifyBatch()
+  os << "inline void classify(Input const& x, double* scores) noexcept {\n"
+        "  double const* leaf = kTree0Leaves[tree0(x)];\n"
+        "  for (size_t l = 0; l < kNumberOfLabels; ++l) {\n"
+        "    scores[l] = leaf[l];\n"
+        "  }\n";
+  for (size_t t = 1; t < trees.size(); ++t) {
+    os << "  leaf = kTree" << t << "Leaves[tree" << t << "(x)];\n"
+       << "  for (size_t l = 0; l < kNumberOfLabels; ++l) {\n"
+          "    scores[l] = 0.5 * scores[l] + 0.5 * leaf[l];\n"
+          "  }\n";
+  }
+  os << "}\n\n";
+
+  os << "inline rf::Label predict(Input const& x) noexcept {\n"
+        "  double scores[kNumberOfLabels];\n"
+        "  classify(x, scores);\n"
+        "  size_t best = 0;\n"
+        "  for (size_t l = 1; l < kNumberOfLabels; ++l) {\n"
+        "    best = scores[l] > scores[best] ? l : best;\n"
+        "  }\n"
+        "  return static_cast<rf::Label>(best);\n"
+        "}\n\n"
+     << "}  // namespace " << options.namespaceName << '\n';
+
+  if (!os) {
+    throw std::runtime_error("failed to write the forest");
+  }
+}
+
+template <typename SplitCandidate, typename Distribution>
+void exportForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                  std::string const& path, ExportOptions const& options) {
+  std::ofstream file{path, std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error("cannot create " + path);
+  }
+  exportForest(forest, file, options);
+  file.close();
+  if (!file) {
+    throw std::runtime_error("failed to write " + path);
+  }
+}
+
+}  // namespace rf
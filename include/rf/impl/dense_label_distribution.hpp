@@ -0,0 +1,75 @@
+#include <rf/dense_label_distribution.h>
+
+#include <cassert>
+#include <cmath>
+
+namespace rf {
+
+template <size_t NumLabels>
+template <typename InputIterator>
+DenseLabelDistribution<NumLabels>::DenseLabelDistribution(InputIterator begin,
+                                                          InputIterator end) {
+  double total = 0.0;
+  for (auto it = begin; it != end; ++it) {
+    const auto label = static_cast<Label>(it->second);
+    if (label >= NumLabels) {
+      continue;
+    }
+    prob_[label] += 1.0;
+    total += 1.0;
+  }
+
+  normalize(total);
+  updateMaxProb();
+}
+
+template <size_t NumLabels>
+DenseLabelDistribution<NumLabels>& DenseLabelDistribution<NumLabels>::combine(
+    DenseLabelDistribution const& other) noexcept {
+  double total = 0.0;
+  for (size_t i = 0; i < NumLabels; ++i) {
+    prob_[i] += other.prob_[i];
+    total += prob_[i];
+  }
+
+  normalize(total);
+  updateMaxProb();
+
+  return *this;
+}
+
+template <size_t NumLabels>
+double DenseLabelDistribution<NumLabels>::entropy() const noexcept {
+  double entropy = 0.0;
+  for (size_t i = 0; i < NumLabels; ++i) {
+    const auto p = prob_[i];
+    assert(p >= 0.0 && p <= 1.0);
+    entropy += p > 0.0 ? -p * std::log(p) : 0.0;
+  }
+  return entropy;
+}
+
+template <size_t NumLabels>
+void DenseLabelDistribution<NumLabels>::normalize(double total) noexcept {
+  if (total <= 0.0) {
+    return;
+  }
+
+  const auto scale = 1.0 / total;
+  for (size_t i = 0; i < NumLabels; ++i) {
+    prob_[i] *= scale;
+  }
+}
+
+template <size_t NumLabels>
+void DenseLabelDistribution<NumLabels>::updateMaxProb() noexcept {
+  size_t maxLabel = 0;
+  for (size_t i = 1; i < NumLabels; ++i) {
+    maxLabel = prob_[i] > prob_[maxLabel] ? i : maxLabel;
+  }
+
+  maxLabel_ = static_cast<Label>(maxLabel);
+  maxProb_ = prob_[maxLabel];
+}
+
+}  // namespace rf
@@ -0,0 +1,117 @@
+#include <rf/flat_tree.h>
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace rf {
+
+template <typename SplitCandidate, typename Distribution>
+FlatTree<SplitCandidate, Distribution>::FlatTree(
+    std::vector<Node>&& nodes, std::vector<Distribution>&& leaves, Index root)
+    : root_{root} {
+  auto owner = std::make_shared<
+      std::pair<std::vector<Node>, std::vector<Distribution>>>(
+      std::move(nodes), std::move(leaves));
+  nodes_ = Span<const Node>{owner->first};
+  leaves_ = Span<const Distribution>{owner->second};
+  owner_ = std::move(owner);
+}
+
+namespace impl {
+
+inline void prefetch(void const* address) noexcept {
+#if defined(__GNUC__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+}  // namespace impl
+
+template <typename SplitCandidate, typename Distribution>
+void FlatTree<SplitCandidate, Distribution>::leafIndices(
+    Span<const Data> data, Span<Index> out) const noexcept {
+  auto const* nodes = nodes_.data();
+
+  for (size_t first = 0; first < data.size(); first += kInterleave) {
+    const auto count = std::min(kInterleave, data.size() - first);
+    auto const* group = data.data() + first;
+
+    Index index[kInterleave];
+    std::fill(index, index + count, root_);
+
+    // inputs that reached a leaf stay on it
+    bool descending = !(root_ & kLeaf);
+    while (descending) {
+      descending = false;
+      for (size_t i = 0; i < count; ++i) {
+        if (index[i] & kLeaf) {
+          continue;
+        }
+
+        auto const& node = nodes[index[i]];
+        const auto next =
+            node.children[static_cast<size_t>(node.split.classify(group[i]))];
+        if (!(next & kLeaf)) {
+          impl::prefetch(nodes + next);
+          descending = true;
+        }
+        index[i] = next;
+      }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      out[first + i] = index[i] & ~kLeaf;
+    }
+  }
+}
+
+template <typename SplitCandidate, typename Data, typename Distribution>
+FlatTree<SplitCandidate, Distribution> compileTree(
+    Tree<Data, Distribution> const& tree) {
+  using Flat = FlatTree<SplitCandidate, Distribution>;
+  using Index = typename Flat::Index;
+  using Split = SplitNode<Data, SplitCandidate, Distribution>;
+  using Leaf = LeafNode<Data, Distribution>;
+  using Node = TreeNode<Data, Distribution>;
+
+  std::vector<typename Flat::Node> nodes{};
+  std::vector<Distribution> leaves{};
+  Index root{Flat::kLeaf};
+
+  // node, index of its parent in `nodes` and which child it is
+  std::deque<std::tuple<Node const*, Index, size_t>> queue{};
+  queue.emplace_back(tree.root(), Flat::kLeaf, 0);
+
+  while (!queue.empty()) {
+    auto [node, parent, side] = queue.front();
+    queue.pop_front();
+
+    Index index{};
+    if (auto split = dynamic_cast<Split const*>(node)) {
+      index = static_cast<Index>(nodes.size());
+      nodes.push_back({split->split()});
+      queue.emplace_back(split->left(), index, 0);
+      queue.emplace_back(split->right(), index, 1);
+    } else if (auto leaf = dynamic_cast<Leaf const*>(node)) {
+      index = static_cast<Index>(leaves.size()) | Flat::kLeaf;
+      leaves.push_back(leaf->distribution());
+    } else {
+      throw std::logic_error("unexpected node type, wrong split candidate?");
+    }
+
+    if (parent == Flat::kLeaf) {
+      root = index;
+    } else {
+      nodes[parent].children[side] = index;
+    }
+  }
+
+  return Flat{std::move(nodes), std::move(leaves), root};
+}
+
+}  // namespace rf
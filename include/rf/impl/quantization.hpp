@@ -0,0 +1,102 @@
+#include <rf/quantization.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace rf {
+
+template <size_t NumLabels, typename Probability, typename SplitCandidate,
+          typename Distribution>
+QuantizedForest<SplitCandidate, NumLabels, Probability> quantizeForest(
+    RandomForest<SplitCandidate, Distribution> const& forest) {
+  using Split = QuantizedSplit<SplitCandidate>;
+  using Leaf = QuantizedLabelDistribution<NumLabels, Probability>;
+  using Tree = FlatTree<Split, Leaf>;
+
+  if (forest.numberOfLabels() > NumLabels) {
+    throw std::invalid_argument("the forest predicts more labels than fit");
+  }
+
+  std::vector<Tree> trees{};
+  trees.reserve(forest.trees().size());
+  for (auto const& tree : forest.trees()) {
+    std::vector<typename Tree::Node> nodes{};
+    nodes.reserve(tree.nodes().size());
+    for (auto const& node : tree.nodes()) {
+      auto& quantized = nodes.emplace_back();
+      if constexpr (std::is_same_v<Split, SplitCandidate>) {
+        quantized.split = node.split;
+      } else {
+        quantized.split = node.split.quantize();
+      }
+      quantized.children[0] = node.children[0];
+      quantized.children[1] = node.children[1];
+    }
+
+    std::vector<Leaf> leaves{};
+    leaves.reserve(tree.leaves().size());
+    for (auto const& leaf : tree.leaves()) {
+      leaves.emplace_back(leaf);
+    }
+
+    trees.emplace_back(std::move(nodes), std::move(leaves), tree.root());
+  }
+
+  return QuantizedForest<SplitCandidate, NumLabels, Probability>{
+      std::move(trees), forest.numberOfLabels()};
+}
+
+template <typename SplitCandidate, typename Distribution>
+size_t modelMemory(RandomForest<SplitCandidate, Distribution> const& forest) {
+  using Node = typename FlatTree<SplitCandidate, Distribution>::Node;
+
+  size_t memory = 0;
+  for (auto const& tree : forest.trees()) {
+    memory += tree.nodes().size() * sizeof(Node) +
+              tree.leaves().size() * sizeof(Distribution);
+  }
+  return memory;
+}
+
+template <typename Forest, typename Quantized, typename Data>
+QuantizationReport compareQuantized(Forest const& forest,
+                                    Quantized const& quantized,
+                                    TrainSet<Data>& test) {
+  QuantizationReport report{};
+  report.memory = modelMemory(forest);
+  report.quantizedMemory = modelMemory(quantized);
+
+  double errors = 0.0;
+  double quantizedErrors = 0.0;
+  double agreements = 0.0;
+  double count = 0.0;
+  for (auto iter = test.iter();; iter->next()) {
+    auto value = iter->value();
+    if (!value.has_value()) {
+      break;
+    }
+
+    // one input at a time, the iterator may release what it refers to once
+    // it moves on
+    auto const& [data, label] = value.value();
+    Label predicted{};
+    Label quantizedPredicted{};
+    forest.classifyBatch(Span<const Data>{&data, 1},
+                         Span<Label>{&predicted, 1});
+    quantized.classifyBatch(Span<const Data>{&data, 1},
+                            Span<Label>{&quantizedPredicted, 1});
+    errors += predicted != label ? 1.0 : 0.0;
+    quantizedErrors += quantizedPredicted != label ? 1.0 : 0.0;
+    agreements += predicted == quantizedPredicted ? 1.0 : 0.0;
+    count += 1.0;
+  }
+
+  if (count > 0.0) {
+    report.error = errors / count;
+    report.quantizedError = quantizedErrors / count;
+    report.agreement = agreements / count;
+  }
+  return report;
+}
+
+}  // namespace rf
@@ -0,0 +1,74 @@
+#include <rf/quantized_label_distribution.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rf {
+
+template <size_t NumLabels, typename Probability>
+template <typename Distribution>
+QuantizedLabelDistribution<NumLabels, Probability>::QuantizedLabelDistribution(
+    Distribution const& dist) {
+  dist.forEach([this](Label label, double p) {
+    if (label < NumLabels) {
+      prob_[label] = quantize(p);
+    }
+  });
+}
+
+template <size_t NumLabels, typename Probability>
+QuantizedLabelDistribution<NumLabels, Probability>&
+QuantizedLabelDistribution<NumLabels, Probability>::combine(
+    QuantizedLabelDistribution const& other) noexcept {
+  std::array<double, NumLabels> sum{};
+  double total = 0.0;
+  for (size_t i = 0; i < NumLabels; ++i) {
+    sum[i] = dequantize(prob_[i]) + dequantize(other.prob_[i]);
+    total += sum[i];
+  }
+
+  if (total > 0.0) {
+    for (size_t i = 0; i < NumLabels; ++i) {
+      prob_[i] = quantize(sum[i] / total);
+    }
+  }
+
+  return *this;
+}
+
+template <size_t NumLabels, typename Probability>
+std::pair<Label, double>
+QuantizedLabelDistribution<NumLabels, Probability>::maxProb() const noexcept {
+  size_t maxLabel = 0;
+  double maxProb = dequantize(prob_[0]);
+  for (size_t i = 1; i < NumLabels; ++i) {
+    const auto p = dequantize(prob_[i]);
+    if (p > maxProb) {
+      maxLabel = i;
+      maxProb = p;
+    }
+  }
+  return {static_cast<Label>(maxLabel), maxProb};
+}
+
+template <size_t NumLabels, typename Probability>
+Probability QuantizedLabelDistribution<NumLabels, Probability>::quantize(
+    double p) noexcept {
+  if constexpr (std::is_same_v<Probability, Half>) {
+    return Half{static_cast<float>(p)};
+  } else {
+    return static_cast<uint8_t>(std::lround(std::clamp(p, 0.0, 1.0) * 255.0));
+  }
+}
+
+template <size_t NumLabels, typename Probability>
+double QuantizedLabelDistribution<NumLabels, Probability>::dequantize(
+    Probability p) noexcept {
+  if constexpr (std::is_same_v<Probability, Half>) {
+    return p.toFloat();
+  } else {
+    return p * (1.0 / 255.0);
+  }
+}
+
+}  // namespace rf
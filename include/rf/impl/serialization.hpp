@@ -0,0 +1,206 @@
+#include <rf/mapped_file.h>
+#include <rf/serialization.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace rf {
+namespace impl {
+
+template <typename SplitCandidate, typename Distribution>
+struct ForestLayout {
+  using Tree = FlatTree<SplitCandidate, Distribution>;
+  using Node = typename Tree::Node;
+
+  static_assert(std::is_trivially_copyable_v<SplitCandidate>,
+                "saved split candidates must be trivially copyable");
+  static_assert(std::is_trivially_copyable_v<Distribution>,
+                "saved distributions must be trivially copyable, e.g. "
+                "DenseLabelDistribution");
+  static_assert(alignof(Node) <= format::kAlignment &&
+                    alignof(Distribution) <= format::kAlignment,
+                "over-aligned nodes are not supported");
+
+  static format::FileHeader header(uint64_t numberOfTrees,
+                                   uint32_t numberOfLabels) noexcept {
+    format::FileHeader header{};
+    std::memcpy(header.magic, format::kMagic, sizeof(header.magic));
+    header.version = format::kVersion;
+    header.byteOrder = format::kByteOrder;
+    header.splitVersion = SplitCandidate::serializationVersion();
+    header.nodeSize = sizeof(Node);
+    header.leafSize = sizeof(Distribution);
+    header.numberOfLabels = numberOfLabels;
+    header.numberOfTrees = numberOfTrees;
+    return header;
+  }
+};
+
+inline uint64_t alignOffset(uint64_t offset) noexcept {
+  return (offset + format::kAlignment - 1) / format::kAlignment *
+         format::kAlignment;
+}
+
+}  // namespace impl
+
+template <typename SplitCandidate, typename Distribution>
+void saveForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                std::ostream& os) {
+  using Layout = impl::ForestLayout<SplitCandidate, Distribution>;
+  using Node = typename Layout::Node;
+
+  auto const& trees = forest.trees();
+  const auto header = Layout::header(
+      trees.size(), static_cast<uint32_t>(forest.numberOfLabels()));
+
+  // lay out the arrays after the headers
+  std::vector<format::TreeHeader> treeHeaders(trees.size());
+  uint64_t offset =
+      sizeof(format::FileHeader) + trees.size() * sizeof(format::TreeHeader);
+  for (size_t i = 0; i < trees.size(); ++i) {
+    auto& tree = treeHeaders[i];
+    tree.nodeCount = trees[i].nodes().size();
+    tree.leafCount = trees[i].leaves().size();
+    tree.root = trees[i].root();
+
+    tree.nodesOffset = impl::alignOffset(offset);
+    offset = tree.nodesOffset + tree.nodeCount * sizeof(Node);
+    tree.leavesOffset = impl::alignOffset(offset);
+    offset = tree.leavesOffset + tree.leafCount * sizeof(Distribution);
+  }
+
+  uint64_t position = 0;
+  auto write = [&os, &position](void const* data, uint64_t size,
+                                uint64_t at) {
+    static const char padding[format::kAlignment] = {};
+    os.write(padding, static_cast<std::streamsize>(at - position));
+    os.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+    position = at + size;
+  };
+
+  write(&header, sizeof(header), 0);
+  write(treeHeaders.data(), treeHeaders.size() * sizeof(format::TreeHeader),
+        position);
+  for (size_t i = 0; i < trees.size(); ++i) {
+    auto const& tree = treeHeaders[i];
+    write(trees[i].nodes().data(), tree.nodeCount * sizeof(Node),
+          tree.nodesOffset);
+    write(trees[i].leaves().data(), tree.leafCount * sizeof(Distribution),
+          tree.leavesOffset);
+  }
+
+  if (!os) {
+    throw std::runtime_error("failed to write the forest");
+  }
+}
+
+template <typename SplitCandidate, typename Distribution>
+void saveForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                std::string const& path) {
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error("cannot create " + path);
+  }
+  saveForest(forest, file);
+  file.close();
+  if (!file) {
+    throw std::runtime_error("failed to write " + path);
+  }
+}
+
+template <typename SplitCandidate, typename Distribution>
+RandomForest<SplitCandidate, Distribution> loadForest(
+    std::string const& path) {
+  using Layout = impl::ForestLayout<SplitCandidate, Distribution>;
+  using Tree = typename Layout::Tree;
+  using Node = typename Layout::Node;
+
+  auto file = std::make_shared<const MappedFile>(path);
+  auto const* data = file->data();
+  const uint64_t size = file->size();
+
+  auto invalid = [&path](char const* reason) {
+    return std::runtime_error(path + ": " + reason);
+  };
+
+  format::FileHeader header{};
+  if (size < sizeof(header)) {
+    throw invalid("not a forest file");
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  const auto expected =
+      Layout::header(header.numberOfTrees, header.numberOfLabels);
+  if (std::memcmp(header.magic, format::kMagic, sizeof(header.magic)) != 0) {
+    throw invalid("not a forest file");
+  }
+  if (header.version != format::kVersion) {
+    throw invalid("unsupported format version");
+  }
+  if (header.byteOrder != format::kByteOrder) {
+    throw invalid("saved on a machine with a different byte order");
+  }
+  if (header.splitVersion != expected.splitVersion ||
+      header.nodeSize != expected.nodeSize ||
+      header.leafSize != expected.leafSize) {
+    throw invalid("saved with a different split candidate or distribution");
+  }
+
+  const auto tableSize = header.numberOfTrees * sizeof(format::TreeHeader);
+  if (header.numberOfTrees > size || sizeof(header) + tableSize > size) {
+    throw invalid("truncated file");
+  }
+
+  // an array is valid if it is aligned and fully inside the file
+  auto validArray = [size](uint64_t offset, uint64_t count, uint64_t elemSize) {
+    return offset % format::kAlignment == 0 && offset <= size &&
+           count <= (size - offset) / elemSize;
+  };
+
+  std::vector<Tree> trees{};
+  trees.reserve(header.numberOfTrees);
+  for (uint64_t i = 0; i < header.numberOfTrees; ++i) {
+    format::TreeHeader tree{};
+    std::memcpy(&tree, data + sizeof(header) + i * sizeof(tree), sizeof(tree));
+
+    if (!validArray(tree.nodesOffset, tree.nodeCount, sizeof(Node)) ||
+        !validArray(tree.leavesOffset, tree.leafCount, sizeof(Distribution))) {
+      throw invalid("truncated file");
+    }
+
+    auto nodes = Span<const Node>{
+        reinterpret_cast<Node const*>(data + tree.nodesOffset),
+        static_cast<size_t>(tree.nodeCount)};
+    auto leaves = Span<const Distribution>{
+        reinterpret_cast<Distribution const*>(data + tree.leavesOffset),
+        static_cast<size_t>(tree.leafCount)};
+
+    // every child index has to point inside the arrays. The nodes are in
+    // breadth-first order, a split child comes after its parent, which also
+    // rules out cycles.
+    auto validIndex = [&](uint32_t index) {
+      return index & Tree::kLeaf ? (index & ~Tree::kLeaf) < leaves.size()
+                                 : index < nodes.size();
+    };
+    auto validChild = [&](uint32_t index, size_t parent) {
+      return validIndex(index) && (index & Tree::kLeaf || index > parent);
+    };
+    bool valid = validIndex(tree.root);
+    for (size_t n = 0; n < nodes.size(); ++n) {
+      valid = valid && validChild(nodes[n].children[0], n) &&
+              validChild(nodes[n].children[1], n) && nodes[n].split.valid();
+    }
+    if (!valid) {
+      throw invalid("corrupted tree");
+    }
+
+    trees.emplace_back(nodes, leaves, tree.root, file);
+  }
+
+  return RandomForest<SplitCandidate, Distribution>{std::move(trees),
+                                                    header.numberOfLabels};
+}
+
+}  // namespace rf
@@ -0,0 +1,498 @@
+#include <rf/tree.h>
+
+#include <limits>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace rf {
+namespace impl {
+
+/**
+ *  Loaded chunks of a StreamingTrainSet. When loading a chunk would exceed
+ *  `maxMemory`, the least recently used chunks are unloaded first. Zero
+ *  means no limit. The chunk hinted with prefetch() and the memory the set
+ *  prefetched for the next tree count against it too.
+ */
+template <typename Data>
+class ChunkCache {
+ public:
+  using Examples = std::vector<TrainingExample<Data>>;
+
+  ChunkCache(StreamingTrainSet<Data>& set, size_t maxMemory) noexcept
+      : set_{set}, maxMemory_{maxMemory} {}
+  ~ChunkCache() { clear(); }
+
+  ChunkCache(ChunkCache const&) = delete;
+  ChunkCache& operator=(ChunkCache const&) = delete;
+
+  /**
+   *  Examples of the chunk, valid until the next call to load()
+   */
+  Examples const& load(size_t chunk) {
+    auto it = loaded_.find(chunk);
+    if (it != loaded_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      return it->second.examples;
+    }
+
+    const auto memory = set_.chunkMemory(chunk);
+    if (chunk == hinted_) {
+      memory_ -= hintedMemory_;
+      hinted_ = kNone;
+    }
+    const auto budget = available();
+    while (maxMemory_ > 0 && !lru_.empty() && memory_ + memory > budget) {
+      unload(lru_.back());
+    }
+
+    lru_.push_front(chunk);
+    auto& entry =
+        loaded_.emplace(chunk, Entry{set_.load(chunk), memory, lru_.begin()})
+            .first->second;
+    memory_ += memory;
+    return entry.examples;
+  }
+
+  [[nodiscard]] bool contains(size_t chunk) const {
+    return loaded_.find(chunk) != loaded_.end();
+  }
+
+  /**
+   *  Pass the hint that `chunk` is loaded next to the train set. Its memory
+   *  is counted from now on, the chunks used least recently are unloaded to
+   *  make room for it but not the one load() returned last.
+   */
+  void prefetch(size_t chunk) {
+    if (contains(chunk) || chunk == hinted_) {
+      return;
+    }
+
+    memory_ -= hinted_ == kNone ? 0 : hintedMemory_;
+    const auto memory = set_.chunkMemory(chunk);
+    const auto budget = available();
+    while (maxMemory_ > 0 && lru_.size() > 1 && memory_ + memory > budget) {
+      unload(lru_.back());
+    }
+
+    hinted_ = chunk;
+    hintedMemory_ = memory;
+    memory_ += memory;
+    set_.prefetchChunk(chunk);
+  }
+
+  void clear() {
+    while (!lru_.empty()) {
+      unload(lru_.back());
+    }
+    memory_ -= hinted_ == kNone ? 0 : hintedMemory_;
+    hinted_ = kNone;
+  }
+
+ private:
+  struct Entry {
+    Examples examples;
+    size_t memory;
+    std::list<size_t>::iterator lru;
+  };
+
+  void unload(size_t chunk) {
+    auto it = loaded_.find(chunk);
+    memory_ -= it->second.memory;
+    lru_.erase(it->second.lru);
+    loaded_.erase(it);
+    set_.unload(chunk);
+  }
+
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  // budget left by what the train set prefetched for the next tree
+  [[nodiscard]] size_t available() const {
+    return maxMemory_ - std::min(maxMemory_, set_.prefetchMemory());
+  }
+
+  StreamingTrainSet<Data>& set_;
+  size_t maxMemory_{0};
+  // loaded chunks and the hinted one
+  size_t memory_{0};
+  size_t hinted_{kNone};
+  size_t hintedMemory_{0};
+  std::unordered_map<size_t, Entry> loaded_{};
+  // most recently used first
+  std::list<size_t> lru_{};
+};
+
+/**
+ *  The labels counted in a histogram as a sequence of training examples,
+ *  every label repeated as many times as it is counted. Distributions are
+ *  built from it like from the examples themselves.
+ */
+class CountedLabelIterator {
+ public:
+  struct Example {
+    Label second;
+  };
+
+  CountedLabelIterator(uint32_t const* counts, size_t size,
+                       size_t label) noexcept
+      : counts_{counts}, size_{size}, label_{label} {
+    skipEmpty();
+  }
+
+  Example const& operator*() const noexcept { return example_; }
+  Example const* operator->() const noexcept { return &example_; }
+
+  CountedLabelIterator& operator++() noexcept {
+    if (++repeat_ == counts_[label_]) {
+      repeat_ = 0;
+      ++label_;
+      skipEmpty();
+    }
+    return *this;
+  }
+
+  bool operator==(CountedLabelIterator const& other) const noexcept {
+    return label_ == other.label_ && repeat_ == other.repeat_;
+  }
+  bool operator!=(CountedLabelIterator const& other) const noexcept {
+    return !(*this == other);
+  }
+
+ private:
+  void skipEmpty() noexcept {
+    while (label_ < size_ && counts_[label_] == 0) {
+      ++label_;
+    }
+    example_.second = static_cast<Label>(label_);
+  }
+
+  uint32_t const* counts_;
+  size_t size_;
+  size_t label_;
+  uint32_t repeat_{0};
+  Example example_{};
+};
+
+/**
+ *  Train a tree on a StreamingTrainSet one depth level at a time.
+ *
+ *  The frontier node of every sample is kept in a compact array of indices,
+ *  and the label counts of every node are derived from the split of its
+ *  parent. For every level the chunks are streamed through a ChunkCache,
+ *  in alternating directions so the chunks still cached are used first, and
+ *  the next chunk to load is prefetched while one is processed. A
+ *  pass over a chunk first routes its samples to the nodes chosen by the
+ *  previous level, then counts the labels going to the left of every
+ *  candidate of their node. Large levels take several passes, bounded to
+ *  kMaxCandidatesPerPass candidates.
+ *
+ *  Candidates are scored with their own threshold, the threshold search
+ *  modes need the samples of a node at once and are not used.
+ */
+template <typename SplitCandidate, typename Distribution, typename Data>
+Tree<Data, Distribution> growStreamingTree(StreamingTrainSet<Data>& train,
+                                           TreeParameters const& conf,
+                                           ThreadPool& pool, Random rng) {
+  using Leaf = LeafNode<Data, Distribution>;
+  using Split = SplitNode<Data, SplitCandidate, Distribution>;
+  using Node = NodePtr<Data, Distribution>;
+  constexpr auto kDone = std::numeric_limits<uint32_t>::max();
+
+  // the samples are numbered in chunk order
+  const auto chunks = train.chunks();
+  std::vector<size_t> offsets(chunks + 1, 0);
+  size_t numberOfLabels = 1;
+  for (size_t c = 0; c < chunks; ++c) {
+    const auto labels = train.labels(c);
+    offsets[c + 1] = offsets[c] + labels.size();
+    for (const auto label : labels) {
+      numberOfLabels = std::max<size_t>(numberOfLabels, label + size_t{1});
+    }
+  }
+  const auto samples = offsets.back();
+  const auto L = numberOfLabels;
+
+  struct FrontierNode {
+    Random rng;
+    // null for the root
+    Split* parent;
+    SplitResult side;
+  };
+
+  // where the samples of a node split by the previous level go
+  struct Route {
+    SplitCandidate split;
+    uint32_t left;
+    uint32_t right;
+  };
+
+  struct Active {
+    uint32_t node;
+    std::vector<SplitCandidate> candidates;
+    // first candidate in the counts of its pass
+    size_t offset;
+    size_t best;
+    double gain;
+    size_t rejected;
+  };
+
+  std::vector<FrontierNode> frontier{{rng, nullptr, SplitResult::LEFT}};
+  // label counts of the frontier nodes, L per node
+  std::vector<uint32_t> counts(L, 0);
+  for (size_t c = 0; c < chunks; ++c) {
+    for (const auto label : train.labels(c)) {
+      counts[label]++;
+    }
+  }
+  std::vector<uint32_t> membership(samples, 0);
+  std::vector<Route> routes{};
+
+  auto arena = std::make_unique<Arena>(
+      initialArenaSize(samples, conf, sizeof(Leaf) + sizeof(Split)));
+
+  Node root{nullptr};
+  auto attach = [&root](FrontierNode const& node, Node child) {
+    if (node.parent == nullptr) {
+      root = child;
+    } else if (node.side == SplitResult::LEFT) {
+      node.parent->setLeftChild(child);
+    } else {
+      node.parent->setRightChild(child);
+    }
+  };
+
+  auto* observer = conf.observer;
+  auto total = [L](uint32_t const* row) {
+    size_t sum = 0;
+    for (size_t l = 0; l < L; ++l) {
+      sum += row[l];
+    }
+    return sum;
+  };
+  auto makeLeaf = [&](size_t node, size_t depth) {
+    auto const* row = counts.data() + node * L;
+    attach(frontier[node],
+           arena->create<Leaf>(CountedLabelIterator{row, L, 0},
+                               CountedLabelIterator{row, L, L}));
+    if (observer) {
+      observer->onLeaf({depth, total(row), 0.0});
+    }
+  };
+
+  ChunkCache<Data> cache{train, conf.maxSampleMemory};
+  bool forward = true;
+
+  for (size_t depth = 0; !frontier.empty(); ++depth) {
+    std::vector<Active> active{};
+    std::vector<uint32_t> activeOf(frontier.size(), kDone);
+    for (uint32_t node = 0; node < frontier.size(); ++node) {
+      const auto nodeSamples = total(counts.data() + node * L);
+      if (depth > conf.maxDepth || nodeSamples < conf.minSamplesPerNode ||
+          nodeSamples == 0) {
+        makeLeaf(node, depth);
+        continue;
+      }
+
+      activeOf[node] = static_cast<uint32_t>(active.size());
+      auto& a = active.emplace_back(Active{node, {}, 0, 0, 0.0, 0});
+      a.candidates.reserve(conf.candidatesToGeneratePerNode);
+      for (size_t i = 0; i < conf.candidatesToGeneratePerNode; ++i) {
+        a.candidates.emplace_back(SplitCandidate::generate(frontier[node].rng));
+      }
+    }
+
+    // label counts of the left side of the best candidates, L per node
+    std::vector<uint32_t> bestLeft(active.size() * L, 0);
+    bool routed = routes.empty();
+
+    for (size_t first = 0; first < active.size();) {
+      size_t last = first;
+      size_t candidates = 0;
+      while (last < active.size() &&
+             (last == first ||
+              candidates + active[last].candidates.size() <=
+                  kMaxCandidatesPerPass)) {
+        active[last].offset = candidates;
+        candidates += active[last].candidates.size();
+        ++last;
+      }
+
+      std::vector<uint32_t> leftCounts(candidates * L, 0);
+      const auto tasks = std::min(pool.size(), last - first);
+
+      // once routed, chunks without samples in this pass are not loaded
+      std::vector<size_t> passChunks{};
+      for (size_t i = 0; i < chunks; ++i) {
+        const auto chunk = forward ? i : chunks - 1 - i;
+        auto const* member = membership.data() + offsets[chunk];
+        auto const* memberEnd = membership.data() + offsets[chunk + 1];
+        if (routed && std::none_of(member, memberEnd, [&](auto m) {
+              return m != kDone && activeOf[m] >= first && activeOf[m] < last;
+            })) {
+          continue;
+        }
+        passChunks.push_back(chunk);
+      }
+
+      for (size_t i = 0; i < passChunks.size(); ++i) {
+        const auto chunk = passChunks[i];
+        const auto begin = offsets[chunk];
+        const auto size = offsets[chunk + 1] - begin;
+        auto* member = membership.data() + begin;
+
+        auto const& examples = cache.load(chunk);
+        if (i + 1 < passChunks.size()) {
+          cache.prefetch(passChunks[i + 1]);
+        }
+        const auto labels = train.labels(chunk);
+
+        if (!routed) {
+          const auto slices = std::max<size_t>(1, pool.size());
+          runJobs(
+              pool, slices, conf.minSamplesPerTask,
+              [&](size_t) { return size / slices; },
+              [&](size_t s) {
+                for (size_t k = s * size / slices; k < (s + 1) * size / slices;
+                     ++k) {
+                  if (member[k] == kDone) {
+                    continue;
+                  }
+                  auto const& route = routes[member[k]];
+                  if (route.left == kDone) {
+                    member[k] = kDone;
+                  } else {
+                    member[k] = route.split.classify(examples[k].first) ==
+                                        SplitResult::LEFT
+                                    ? route.left
+                                    : route.right;
+                  }
+                }
+              });
+        }
+
+        // every task owns the counts of a range of nodes
+        runJobs(
+            pool, tasks, conf.minSamplesPerTask,
+            [&](size_t) { return size; },
+            [&](size_t t) {
+              const auto from = first + t * (last - first) / tasks;
+              const auto to = first + (t + 1) * (last - first) / tasks;
+              for (size_t k = 0; k < size; ++k) {
+                if (member[k] == kDone) {
+                  continue;
+                }
+                const auto a = activeOf[member[k]];
+                if (a < from || a >= to) {
+                  continue;
+                }
+
+                auto const& node = active[a];
+                auto* left = leftCounts.data() + node.offset * L + labels[k];
+                for (auto const& candidate : node.candidates) {
+                  *left += candidate.classify(examples[k].first) ==
+                           SplitResult::LEFT;
+                  left += L;
+                }
+              }
+            });
+      }
+      routed = true;
+
+      for (size_t a = first; a < last; ++a) {
+        auto& node = active[a];
+        LabelHistogram entireSet{};
+        for (size_t l = 0; l < L; ++l) {
+          entireSet.add(static_cast<Label>(l), counts[node.node * L + l]);
+        }
+        const auto impurity = entireSet.impurity(conf.criterion);
+
+        std::vector<double> scores(node.candidates.size(), 0.0);
+        for (size_t c = 0; c < scores.size(); ++c) {
+          auto const* row = leftCounts.data() + (node.offset + c) * L;
+          LabelHistogram leftSet{};
+          for (size_t l = 0; l < L; ++l) {
+            leftSet.add(static_cast<Label>(l), row[l]);
+          }
+          scores[c] =
+              informationGain(leftSet, entireSet, impurity, conf.criterion);
+        }
+
+        node.best = bestScore(scores);
+        node.rejected = rejectedCandidates(scores);
+        if (node.best < scores.size()) {
+          node.gain = scores[node.best];
+          std::copy_n(leftCounts.data() + (node.offset + node.best) * L, L,
+                      bestLeft.data() + a * L);
+        }
+      }
+
+      first = last;
+    }
+
+    // split the nodes and build the next level
+    std::vector<FrontierNode> nextFrontier{};
+    std::vector<uint32_t> nextCounts{};
+    routes.assign(frontier.size(), Route{SplitCandidate{}, kDone, kDone});
+
+    for (size_t a = 0; a < active.size(); ++a) {
+      auto& node = active[a];
+      if (node.best == node.candidates.size()) {
+        makeLeaf(node.node, depth);
+        continue;
+      }
+
+      auto const* row = counts.data() + node.node * L;
+      auto const* left = bestLeft.data() + a * L;
+      if (observer) {
+        observer->onSplit(
+            {depth, total(row), node.gain, node.rejected, 0.0, 0.0, 0.0});
+      }
+
+      auto& frontierNode = frontier[node.node];
+      auto split = arena->create<Split>(
+          SplitCandidate{node.candidates[node.best]});
+      attach(frontierNode, split);
+
+      const auto leftSeed = frontierNode.rng();
+      const auto rightSeed = frontierNode.rng();
+      const auto leftIndex = static_cast<uint32_t>(nextFrontier.size());
+      routes[node.node] = {node.candidates[node.best], leftIndex,
+                           leftIndex + 1};
+
+      nextFrontier.push_back({Random{leftSeed}, split, SplitResult::LEFT});
+      nextFrontier.push_back({Random{rightSeed}, split, SplitResult::RIGHT});
+      nextCounts.insert(nextCounts.end(), left, left + L);
+      for (size_t l = 0; l < L; ++l) {
+        nextCounts.push_back(row[l] - left[l]);
+      }
+    }
+
+    frontier.swap(nextFrontier);
+    counts.swap(nextCounts);
+    forward = !forward;
+  }
+
+  return Tree<Data, Distribution>{std::move(arena), root};
+}
+
+}  // namespace impl
+
+template <typename SplitCandidate, typename Distribution, typename InputData>
+Tree<InputData, Distribution> trainTree(StreamingTrainSet<InputData>& train,
+                                        TreeParameters stoppingCriteria) {
+  ThreadPool pool{stoppingCriteria.numberOfThreads};
+  return trainTree<SplitCandidate, Distribution>(train, stoppingCriteria,
+                                                 pool);
+}
+
+template <typename SplitCandidate, typename Distribution, typename InputData>
+Tree<InputData, Distribution> trainTree(StreamingTrainSet<InputData>& train,
+                                        TreeParameters stoppingCriteria,
+                                        ThreadPool& pool) {
+  Random rng{stoppingCriteria.seed};
+  train.sample(rng);
+  return impl::growStreamingTree<SplitCandidate, Distribution>(
+      train, stoppingCriteria, pool, Random{rng()});
+}
+
+}  // namespace rf
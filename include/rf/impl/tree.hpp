@@ -1,110 +1,762 @@
 #include <rf/tree.h>
 
 #include <algorithm>
-#include <future>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <vector>
 
 namespace rf {
 namespace impl {
 
+using Clock = std::chrono::steady_clock;
+
+inline double secondsSince(Clock::time_point start) noexcept {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ *  Decrease of impurity of a split given the label counts of its left side
+ *  and of the whole node, the information gain with the entropy. A split
+ *  that keeps all the samples on one side has no gain.
+ */
+inline double informationGain(
+    LabelHistogram const& leftSet, LabelHistogram const& entireSet,
+    double totalImpurity,
+    SplitCriterion criterion = SplitCriterion::ENTROPY) noexcept {
+  if (leftSet.total() == 0 || leftSet.total() == entireSet.total()) {
+    return 0.0;
+  }
+
+  const auto rightSet = entireSet - leftSet;
+  const auto leftTotal = static_cast<double>(leftSet.total());
+  const auto rightTotal = static_cast<double>(rightSet.total());
+  const auto entireTotal = static_cast<double>(entireSet.total());
+
+  return totalImpurity -
+         ((leftTotal / entireTotal) * leftSet.impurity(criterion) +
+          (rightTotal / entireTotal) * rightSet.impurity(criterion));
+}
+
+/**
+ *  Information gain of splitting the samples with the candidate, given the
+ *  label counts of the whole node.
+ *
+ *  The samples are only read, a single pass counts the labels that go to the
+ *  left and the right counts are derived from the node counts. Several
+ *  candidates can be scored at the same time on the same samples.
+ */
+template <typename SplitCandidate, typename InputIterator>
+double evaluateSplitCandidate(
+    SplitCandidate const& candidate, InputIterator begin, InputIterator end,
+    LabelHistogram const& entireSet, double totalImpurity,
+    SplitCriterion criterion = SplitCriterion::ENTROPY) {
+  LabelHistogram leftSet{};
+  for (auto it = begin; it != end; ++it) {
+    const auto isLeft = candidate.classify(it->first) == SplitResult::LEFT;
+    leftSet.add(static_cast<Label>(it->second), isLeft);
+  }
+
+  return informationGain(leftSet, entireSet, totalImpurity, criterion);
+}
+
 template <typename SplitCandidate, typename InputIterator>
 double evaluateSplitCandidate(SplitCandidate const& candidate,
                               InputIterator begin, InputIterator end) {
-  const auto entireSet = LabelDistribution{begin, end};
-  const auto totalEntropy = entireSet.entropy();
+  const auto entireSet = LabelHistogram{begin, end};
+  return evaluateSplitCandidate(candidate, begin, end, entireSet,
+                                entireSet.entropy());
+}
 
-  auto split = std::partition(begin, end, [&candidate](const auto& example) {
-    return candidate.classify(example.first) == SplitResult::LEFT;
-  });
+/**
+ *  Label counts of a node, shared by all its candidates. Candidates with a
+ *  feature response also need the labels in a contiguous array.
+ */
+struct NodeCounts {
+  LabelHistogram histogram{};
+  SplitCriterion criterion{SplitCriterion::ENTROPY};
+  double impurity{0.0};
+  std::vector<Label> labels{};
+};
 
-  // there is no gain
-  if (split == begin || split == end) {
-    return 0.0;
+template <typename SplitCandidate, typename InputIterator>
+NodeCounts countNode(InputIterator begin, InputIterator end,
+                     LabelHistogram const& histogram,
+                     SplitCriterion criterion) {
+  NodeCounts counts{histogram, criterion, histogram.impurity(criterion)};
+
+  if constexpr (isFeatureResponse<SplitCandidate>) {
+    counts.labels.reserve(static_cast<size_t>(std::distance(begin, end)));
+    for (auto it = begin; it != end; ++it) {
+      counts.labels.push_back(static_cast<Label>(it->second));
+    }
+  }
+
+  return counts;
+}
+
+template <typename SplitCandidate, typename InputIterator>
+NodeCounts countNode(InputIterator begin, InputIterator end,
+                     SplitCriterion criterion) {
+  return countNode<SplitCandidate>(begin, end, LabelHistogram{begin, end},
+                                   criterion);
+}
+
+/**
+ *  Candidates of a node. Every generated candidate, a feature, is followed by
+ *  the copies trying its extra thresholds: `thresholds` consecutive
+ *  candidates share the same feature. When sweeping, exactly or over bins,
+ *  the threshold of every candidate is replaced by its best one.
+ */
+template <typename SplitCandidate>
+struct CandidateSet {
+  std::vector<SplitCandidate> candidates{};
+  // samples whose responses are the extra thresholds, `thresholds - 1` per
+  // feature
+  std::vector<size_t> thresholdSamples{};
+  size_t thresholds{1};
+  ThresholdSearch search{ThresholdSearch::RANDOM};
+  size_t bins{0};
+
+  [[nodiscard]] size_t features() const noexcept {
+    return candidates.size() / thresholds;
+  }
+};
+
+template <typename SplitCandidate>
+CandidateSet<SplitCandidate> generateCandidates(TreeParameters const& conf,
+                                                size_t samples, Random& rng) {
+  CandidateSet<SplitCandidate> set{};
+  if constexpr (isFeatureResponse<SplitCandidate>) {
+    set.search = conf.thresholdSearch;
+    set.bins = conf.histogramBins;
+    if (samples > 0 && set.search == ThresholdSearch::RANDOM) {
+      set.thresholds = std::max<size_t>(1, conf.thresholdsPerFeature);
+    }
+  }
+
+  const auto n = conf.candidatesToGeneratePerNode;
+  std::uniform_int_distribution<size_t> sampleDist{0, samples - 1};
+  set.candidates.reserve(n * set.thresholds);
+  set.thresholdSamples.reserve(n * (set.thresholds - 1));
+  for (size_t i = 0; i < n; ++i) {
+    set.candidates.emplace_back(SplitCandidate::generate(rng));
+    for (size_t t = 1; t < set.thresholds; ++t) {
+      set.candidates.push_back(set.candidates[i * set.thresholds]);
+      set.thresholdSamples.push_back(sampleDist(rng));
+    }
   }
 
-  auto leftSet = LabelDistribution{begin, split};
-  auto rightSet = LabelDistribution{split, end};
-  auto leftTotal = static_cast<double>(std::distance(begin, split));
-  auto rightTotal = static_cast<double>(std::distance(split, end));
-  auto entireTotal = static_cast<double>(std::distance(begin, end));
+  return set;
+}
 
-  // Information gain
-  const double informationGain =
-      totalEntropy - ((leftTotal / entireTotal) * leftSet.entropy() +
-                      (rightTotal / entireTotal) * rightSet.entropy());
+/**
+ *  Information gain of splitting the node at `threshold`, the responses are
+ *  in the order of `counts.labels`.
+ */
+inline double scoreThreshold(std::vector<float> const& responses,
+                             NodeCounts const& counts,
+                             float threshold) noexcept {
+  LabelHistogram leftSet{};
+  for (size_t i = 0; i < responses.size(); ++i) {
+    leftSet.add(counts.labels[i], responses[i] < threshold);
+  }
 
-  return informationGain;
+  return informationGain(leftSet, counts.histogram, counts.impurity,
+                         counts.criterion);
 }
 
+/**
+ *  Score the candidates of the features [first, last) of the set on the
+ *  samples of the node. Feature responses are computed once for all the
+ *  thresholds of a feature, or once for the sweep over all its thresholds.
+ *  Nodes with fewer samples than bins are swept exactly.
+ */
 template <typename SplitCandidate, typename InputIterator>
-SplitCandidate findCandidate(InputIterator begin, InputIterator end, size_t n) {
+void scoreFeatures(CandidateSet<SplitCandidate>& set, size_t first,
+                   size_t last, InputIterator begin, InputIterator end,
+                   NodeCounts const& counts, std::vector<double>& scores) {
+  const auto k = set.thresholds;
+
+  if constexpr (isFeatureResponse<SplitCandidate>) {
+    std::vector<float> responses(counts.labels.size());
+
+    if (set.search == ThresholdSearch::HISTOGRAM &&
+        responses.size() > set.bins) {
+      for (size_t f = first; f < last; ++f) {
+        auto& candidate = set.candidates[f];
+        candidate.responses(begin, end, responses.data());
+
+        const auto best = sweepBinnedThresholds(
+            responses, counts.labels, counts.histogram, counts.impurity,
+            set.bins, counts.criterion);
+        candidate.setThreshold(best.threshold);
+        scores[f] = best.gain;
+      }
+      return;
+    }
+
+    if (set.search != ThresholdSearch::RANDOM) {
+      std::vector<std::pair<float, Label>> sorted(responses.size());
+      for (size_t f = first; f < last; ++f) {
+        auto& candidate = set.candidates[f];
+        candidate.responses(begin, end, responses.data());
+        for (size_t i = 0; i < responses.size(); ++i) {
+          sorted[i] = {responses[i], counts.labels[i]};
+        }
+
+        const auto best =
+            sweepThresholds(sorted, counts.histogram, counts.impurity,
+                            counts.criterion);
+        candidate.setThreshold(best.threshold);
+        scores[f] = best.gain;
+      }
+      return;
+    }
+
+    for (size_t f = first; f < last; ++f) {
+      auto* candidates = set.candidates.data() + f * k;
+      candidates[0].responses(begin, end, responses.data());
+      for (size_t t = 1; t < k; ++t) {
+        const auto sample = set.thresholdSamples[f * (k - 1) + t - 1];
+        candidates[t].setThreshold(responses[sample]);
+      }
+
+      for (size_t t = 0; t < k; ++t) {
+        scores[f * k + t] =
+            scoreThreshold(responses, counts, candidates[t].threshold());
+      }
+    }
+  } else {
+    for (size_t i = first * k; i < last * k; ++i) {
+      scores[i] = evaluateSplitCandidate(set.candidates[i], begin, end,
+                                         counts.histogram, counts.impurity,
+                                         counts.criterion);
+    }
+  }
+}
+
+/**
+ *  Index of the candidate with the highest score, the first one wins ties.
+ *  Returns `scores.size()` when no candidate has any gain.
+ */
+inline size_t bestScore(std::vector<double> const& scores) noexcept {
+  auto best = scores.size();
   double maxScore = 0.0;
-  SplitCandidate bestCandidate{};
-  for (size_t i = 0; i < n; ++i) {
-    auto candidate = SplitCandidate::generate();
-    auto score = evaluateSplitCandidate(candidate, begin, end);
-    if (score > maxScore) {
-      bestCandidate = candidate;
-      maxScore = score;
+  for (size_t i = 0; i < scores.size(); ++i) {
+    if (scores[i] > maxScore) {
+      best = i;
+      maxScore = scores[i];
     }
   }
+  return best;
+}
+
+inline size_t rejectedCandidates(std::vector<double> const& scores) noexcept {
+  return static_cast<size_t>(std::count_if(
+      scores.begin(), scores.end(), [](double score) { return score <= 0.0; }));
+}
+
+/**
+ *  Generate `conf.candidatesToGeneratePerNode` candidates and return the one
+ *  with the highest information gain. Candidates with a feature response try
+ *  `conf.thresholdsPerFeature` thresholds each.
+ *
+ *  The candidates are generated in order on the calling thread and scored in
+ *  parallel. Ties are resolved in favour of the first candidate generated, so
+ *  the result does not depend on the number of threads.
+ *
+ *  `histogram` holds the label counts of the samples. If `statistics` is
+ *  given the gain, the rejected candidates and the time spent generating and
+ *  scoring are written into it. Returns nothing when no candidate has any
+ *  gain, the node is then a leaf.
+ */
+template <typename SplitCandidate, typename InputIterator>
+std::optional<SplitCandidate> findCandidate(
+    InputIterator begin, InputIterator end, TreeParameters const& conf,
+    ThreadPool& pool, Random& rng, LabelHistogram const& histogram,
+    SplitStatistics* statistics = nullptr) {
+  const auto samples = static_cast<size_t>(std::distance(begin, end));
+  const auto start = statistics ? Clock::now() : Clock::time_point{};
+
+  auto set = generateCandidates<SplitCandidate>(conf, samples, rng);
+
+  const auto generated = statistics ? Clock::now() : Clock::time_point{};
+
+  const auto counts =
+      countNode<SplitCandidate>(begin, end, histogram, conf.criterion);
+  const auto n = set.candidates.size();
+  const auto features = set.features();
+
+  std::vector<double> scores(n, 0.0);
+  auto scoreCandidates = [&](size_t first, size_t last) {
+    scoreFeatures(set, first, last, begin, end, counts, scores);
+  };
+
+  const auto chunks = std::min(features, 4 * pool.size());
+  if (chunks <= 1 || samples < conf.minSamplesPerTask) {
+    scoreCandidates(0, features);
+  } else {
+    TaskGroup scoring{pool};
+    for (size_t c = 0; c < chunks; ++c) {
+      scoring.run([&scoreCandidates, c, chunks, features] {
+        scoreCandidates(c * features / chunks, (c + 1) * features / chunks);
+      });
+    }
+    scoring.wait();
+  }
+
+  const auto best = bestScore(scores);
+
+  if (statistics) {
+    statistics->gain = best < n ? scores[best] : 0.0;
+    statistics->rejectedCandidates = rejectedCandidates(scores);
+    statistics->generateSeconds =
+        std::chrono::duration<double>(generated - start).count();
+    statistics->scoreSeconds = secondsSince(generated);
+  }
 
-  return bestCandidate;
+  if (best == n) {
+    return std::nullopt;
+  }
+  return std::move(set.candidates[best]);
 }
 
 template <typename SplitCandidate, typename InputIterator>
-SplitCandidate findCandidate(InputIterator begin, InputIterator end, size_t n);
+std::optional<SplitCandidate> findCandidate(
+    InputIterator begin, InputIterator end, TreeParameters const& conf,
+    ThreadPool& pool, Random& rng) {
+  return findCandidate<SplitCandidate>(begin, end, conf, pool, rng,
+                                       LabelHistogram{begin, end});
+}
 
-template <typename SplitCandidate, typename InputIterator,
+template <typename SplitCandidate, typename Distribution,
+          typename InputIterator,
           typename TrainingExample = typename InputIterator::value_type,
           typename Data = typename TrainingExample::first_type>
-NodePtr<Data> trainNode(InputIterator begin, InputIterator end,
-                        TreeParameters conf,
-                        size_t currentDepth) {  // stop criteria
-  if (currentDepth > conf.maxDepth ||
-      std::distance(begin, end) < conf.minSamplesPerNode) {
-    return std::make_unique<LeafNode<Data>>(begin, end);
+NodePtr<Data, Distribution> trainNode(InputIterator begin, InputIterator end,
+                                      TreeParameters conf,
+                                      size_t currentDepth, ThreadPool& pool,
+                                      Random rng, Arena& arena,
+                                      LabelHistogram const& histogram) {
+  // stop criteria
+  using Leaf = LeafNode<Data, Distribution>;
+  using Split = SplitNode<Data, SplitCandidate, Distribution>;
+
+  const auto samples = static_cast<size_t>(std::distance(begin, end));
+  auto* observer = conf.observer;
+
+  // `searchSeconds` is the time spent on a split that was not used
+  auto makeLeaf = [&](double searchSeconds = 0.0) {
+    const auto start = observer ? Clock::now() : Clock::time_point{};
+    auto leaf = arena.create<Leaf>(begin, end);
+    if (observer) {
+      observer->onLeaf(
+          {currentDepth, samples, searchSeconds + secondsSince(start)});
+    }
+    return leaf;
+  };
+
+  if (currentDepth > conf.maxDepth || samples < conf.minSamplesPerNode) {
+    return makeLeaf();
   }
 
   // Generate a split node
-  auto candidate = findCandidate<SplitCandidate>(
-      begin, end, conf.candidatesToGeneratePerNode);
+  SplitStatistics statistics{currentDepth, samples};
+  auto candidate =
+      findCandidate<SplitCandidate>(begin, end, conf, pool, rng, histogram,
+                                    observer ? &statistics : nullptr);
+  if (!candidate) {
+    return makeLeaf(statistics.generateSeconds + statistics.scoreSeconds);
+  }
 
-  // reorder the samples according to the split candidate
+  // only the chosen candidate reorders the samples
+  const auto start = observer ? Clock::now() : Clock::time_point{};
   auto mid = std::partition(begin, end, [&candidate](auto const& sample) {
-    return candidate.classify(sample.first) == SplitResult::LEFT;
+    return candidate->classify(sample.first) == SplitResult::LEFT;
   });
 
+  if (observer) {
+    statistics.partitionSeconds = secondsSince(start);
+  }
+
   if (mid == begin || mid == end) {
-    return std::make_unique<LeafNode<Data>>(begin, end);
+    return makeLeaf(statistics.generateSeconds + statistics.scoreSeconds +
+                    statistics.partitionSeconds);
+  }
+
+  if (observer) {
+    observer->onSplit(statistics);
+  }
+
+  // only the smaller child is counted, the other one gets the difference
+  // with the counts of this node
+  LabelHistogram leftCounts{};
+  LabelHistogram rightCounts{};
+  if (mid - begin <= end - mid) {
+    leftCounts = LabelHistogram{begin, mid};
+    rightCounts = histogram - leftCounts;
+  } else {
+    rightCounts = LabelHistogram{mid, end};
+    leftCounts = histogram - rightCounts;
   }
 
-  // Build the children asynchronously
-  // this might not be a good idea
-  auto trainChild = [conf, currentDepth](auto begin, auto end) {
-    return trainNode<SplitCandidate>(begin, end, conf, currentDepth + 1);
+  // the children get their own generators so the tree does not depend on
+  // the order in which they are trained
+  auto trainChild = [conf, currentDepth, &pool, &arena](
+                        auto begin, auto end, uint64_t seed,
+                        LabelHistogram const& counts) {
+    return trainNode<SplitCandidate, Distribution>(
+        begin, end, conf, currentDepth + 1, pool, Random{seed}, arena,
+        counts);
   };
-  auto leftChild = std::async(std::launch::async, trainChild, begin, mid);
-  auto rightChild = std::async(std::launch::async, trainChild, mid, end);
+  const auto leftSeed = rng();
+  const auto rightSeed = rng();
+
+  NodePtr<Data, Distribution> leftChild{nullptr};
+  NodePtr<Data, Distribution> rightChild{nullptr};
+
+  // Small subtrees are not worth a task, train them on this thread
+  if (samples < conf.minSamplesPerTask) {
+    leftChild = trainChild(begin, mid, leftSeed, leftCounts);
+    rightChild = trainChild(mid, end, rightSeed, rightCounts);
+  } else {
+    TaskGroup children{pool};
+    children.run([&] {
+      rightChild = trainChild(mid, end, rightSeed, rightCounts);
+    });
+    leftChild = trainChild(begin, mid, leftSeed, leftCounts);
+    children.wait();
+  }
 
   // Create the splitnode and continue training the children
-  auto splitNode =
-      std::make_unique<SplitNode<Data, SplitCandidate>>(std::move(candidate));
-  splitNode->setLeftChild(leftChild.get());
-  splitNode->setRightChild(rightChild.get());
+  auto splitNode = arena.create<Split>(std::move(*candidate));
+  splitNode->setLeftChild(leftChild);
+  splitNode->setRightChild(rightChild);
 
   return splitNode;
 }
 
+/**
+ *  Run `job(i)` for every `i` below `count` on the pool. Consecutive jobs are
+ *  grouped into a task until they cover `minSamples` samples, `samples(i)`
+ *  being the samples read by job `i`.
+ */
+template <typename Samples, typename Job>
+void runJobs(ThreadPool& pool, size_t count, size_t minSamples,
+             Samples const& samples, Job const& job) {
+  TaskGroup group{pool};
+  size_t first = 0;
+  size_t batched = 0;
+  for (size_t i = 0; i < count; ++i) {
+    batched += samples(i);
+    if (batched >= minSamples || i + 1 == count) {
+      group.run([&job, first, last = i + 1] {
+        for (size_t j = first; j < last; ++j) {
+          job(j);
+        }
+      });
+      first = i + 1;
+      batched = 0;
+    }
+  }
+  group.wait();
+}
+
+// Bound on the candidates held at the same time by the level-synchronous
+// training, a wide level is processed in several passes
+constexpr size_t kMaxCandidatesPerPass = size_t{1} << 16;
+
+/**
+ *  Train the tree one depth level at a time.
+ *
+ *  The samples of a frontier node are a range of [begin, end), found by its
+ *  offsets. For every level the candidates of all the frontier nodes are
+ *  generated, then scored, and the samples partitioned, each step as a pass
+ *  over the samples parallelized over the nodes and over the candidates of
+ *  the large nodes.
+ *
+ *  The samples are kept partitioned by node rather than assigned to their
+ *  node by index as growStreamingTree does: the threshold searches sort or
+ *  bin the responses of a node, which needs its samples together, and the
+ *  partitions are the ones trainNode makes. Every node uses its generator
+ *  like trainNode does, so both modes train the same tree.
+ */
+template <typename SplitCandidate, typename Distribution,
+          typename RandomIterator,
+          typename TrainingExample = typename RandomIterator::value_type,
+          typename Data = typename TrainingExample::first_type>
+NodePtr<Data, Distribution> trainLevels(RandomIterator begin,
+                                        RandomIterator end,
+                                        TreeParameters const& conf,
+                                        ThreadPool& pool, Random rng,
+                                        Arena& arena) {
+  using Leaf = LeafNode<Data, Distribution>;
+  using Split = SplitNode<Data, SplitCandidate, Distribution>;
+  using Node = NodePtr<Data, Distribution>;
+
+  struct FrontierNode {
+    size_t first;
+    size_t last;
+    Random rng;
+    // null for the root
+    Split* parent;
+    SplitResult side;
+  };
+
+  struct Candidates {
+    FrontierNode node;
+    CandidateSet<SplitCandidate> set{};
+    std::vector<double> scores{};
+    NodeCounts counts{};
+    size_t mid{0};
+    size_t best{0};
+    SplitStatistics statistics{};
+  };
+
+  struct ScoreJob {
+    size_t node;
+    size_t first;
+    size_t last;
+    double seconds;
+  };
+
+  auto* observer = conf.observer;
+  // features per node, the candidates of a feature are scored together
+  const auto n = conf.candidatesToGeneratePerNode;
+  const auto thresholds =
+      isFeatureResponse<SplitCandidate> &&
+              conf.thresholdSearch == ThresholdSearch::RANDOM
+          ? std::max<size_t>(1, conf.thresholdsPerFeature)
+          : 1;
+  const auto nodesPerPass = std::max<size_t>(
+      1, kMaxCandidatesPerPass / std::max<size_t>(1, n * thresholds));
+  const auto chunks = std::min(n, 4 * pool.size());
+
+  Node root{nullptr};
+  auto attach = [&root](FrontierNode const& node, Node child) {
+    if (node.parent == nullptr) {
+      root = child;
+    } else if (node.side == SplitResult::LEFT) {
+      node.parent->setLeftChild(child);
+    } else {
+      node.parent->setRightChild(child);
+    }
+  };
+
+  // `searchSeconds` is the time spent on a split that was not used
+  auto makeLeaf = [&](FrontierNode const& node, size_t depth,
+                      double searchSeconds = 0.0) {
+    const auto start = observer ? Clock::now() : Clock::time_point{};
+    attach(node, arena.create<Leaf>(begin + node.first, begin + node.last));
+    if (observer) {
+      observer->onLeaf({depth, node.last - node.first,
+                        searchSeconds + secondsSince(start)});
+    }
+  };
+
+  const auto samples = static_cast<size_t>(std::distance(begin, end));
+  std::vector<FrontierNode> frontier{
+      {0, samples, rng, nullptr, SplitResult::LEFT}};
+  std::vector<FrontierNode> nextLevel{};
+
+  for (size_t depth = 0; !frontier.empty(); ++depth) {
+    for (size_t pass = 0; pass < frontier.size(); pass += nodesPerPass) {
+      const auto passEnd = std::min(frontier.size(), pass + nodesPerPass);
+
+      std::vector<Candidates> level{};
+      for (size_t i = pass; i < passEnd; ++i) {
+        auto const& node = frontier[i];
+        const auto nodeSamples = node.last - node.first;
+        if (depth > conf.maxDepth || nodeSamples < conf.minSamplesPerNode) {
+          makeLeaf(node, depth);
+          continue;
+        }
+
+        const auto start = observer ? Clock::now() : Clock::time_point{};
+        auto& candidates = level.emplace_back(Candidates{node});
+        candidates.set = generateCandidates<SplitCandidate>(
+            conf, nodeSamples, candidates.node.rng);
+        candidates.scores.assign(candidates.set.candidates.size(), 0.0);
+        candidates.statistics.depth = depth;
+        candidates.statistics.samples = nodeSamples;
+        if (observer) {
+          candidates.statistics.generateSeconds = secondsSince(start);
+        }
+      }
+
+      auto nodeSamples = [&level](size_t i) {
+        return level[i].node.last - level[i].node.first;
+      };
+
+      // node counts
+      runJobs(pool, level.size(), conf.minSamplesPerTask, nodeSamples,
+              [&](size_t i) {
+                auto& node = level[i];
+                node.counts = countNode<SplitCandidate>(
+                    begin + node.node.first, begin + node.node.last,
+                    conf.criterion);
+              });
+
+      // candidates of the large nodes are split into several jobs
+      std::vector<ScoreJob> jobs{};
+      for (size_t i = 0; i < level.size(); ++i) {
+        const auto split = nodeSamples(i) < conf.minSamplesPerTask ? 1 : chunks;
+        for (size_t c = 0; c < split; ++c) {
+          jobs.push_back({i, c * n / split, (c + 1) * n / split, 0.0});
+        }
+      }
+
+      runJobs(
+          pool, jobs.size(), conf.minSamplesPerTask,
+          [&](size_t j) { return nodeSamples(jobs[j].node); },
+          [&](size_t j) {
+            auto& job = jobs[j];
+            auto& node = level[job.node];
+            const auto start = observer ? Clock::now() : Clock::time_point{};
+            scoreFeatures(node.set, job.first, job.last,
+                          begin + node.node.first, begin + node.node.last,
+                          node.counts, node.scores);
+            if (observer) {
+              job.seconds = secondsSince(start);
+            }
+          });
+
+      // only the chosen candidates reorder the samples
+      runJobs(pool, level.size(), conf.minSamplesPerTask, nodeSamples,
+              [&](size_t i) {
+                auto& node = level[i];
+                node.best = bestScore(node.scores);
+                if (node.best == node.scores.size()) {
+                  node.mid = node.node.first;
+                  return;
+                }
+
+                const auto start =
+                    observer ? Clock::now() : Clock::time_point{};
+                auto const& candidate = node.set.candidates[node.best];
+                auto mid = std::partition(
+                    begin + node.node.first, begin + node.node.last,
+                    [&candidate](auto const& sample) {
+                      return candidate.classify(sample.first) ==
+                             SplitResult::LEFT;
+                    });
+                node.mid = static_cast<size_t>(std::distance(begin, mid));
+                if (observer) {
+                  node.statistics.partitionSeconds = secondsSince(start);
+                }
+              });
+
+      if (observer) {
+        for (auto const& job : jobs) {
+          level[job.node].statistics.scoreSeconds += job.seconds;
+        }
+      }
+
+      for (auto& node : level) {
+        auto& frontierNode = node.node;
+        if (node.mid == frontierNode.first || node.mid == frontierNode.last) {
+          auto const& statistics = node.statistics;
+          makeLeaf(frontierNode, depth,
+                   statistics.generateSeconds + statistics.scoreSeconds +
+                       statistics.partitionSeconds);
+          continue;
+        }
+
+        if (observer) {
+          node.statistics.gain = node.scores[node.best];
+          node.statistics.rejectedCandidates = rejectedCandidates(node.scores);
+          observer->onSplit(node.statistics);
+        }
+
+        auto split =
+            arena.create<Split>(std::move(node.set.candidates[node.best]));
+        attach(frontierNode, split);
+
+        const auto leftSeed = frontierNode.rng();
+        const auto rightSeed = frontierNode.rng();
+        nextLevel.push_back({frontierNode.first, node.mid, Random{leftSeed},
+                             split, SplitResult::LEFT});
+        nextLevel.push_back({node.mid, frontierNode.last, Random{rightSeed},
+                             split, SplitResult::RIGHT});
+      }
+    }
+
+    frontier.swap(nextLevel);
+    nextLevel.clear();
+  }
+
+  return root;
+}
+
+// Largest first block of the arena of a tree, the next blocks grow
+// geometrically from it
+constexpr size_t kMaxInitialArenaSize = size_t{64} << 20;
+
+/**
+ *  Size of the first block of the arena of a tree, `nodeSize` being the size
+ *  of a leaf and a split node. Leaves hold a sample at least, the number of
+ *  leaves is bounded by the samples, `minSamplesPerNode` and `maxDepth`.
+ */
+inline size_t initialArenaSize(size_t samples, TreeParameters const& conf,
+                               size_t nodeSize) noexcept {
+  auto leaves = samples / std::max<size_t>(1, conf.minSamplesPerNode) + 1;
+  leaves = std::min(leaves, std::max<size_t>(1, samples));
+  if (conf.maxDepth < 32) {
+    leaves = std::min(leaves, size_t{1} << (conf.maxDepth + 1));
+  }
+  return std::clamp<size_t>(leaves * nodeSize, 4096, kMaxInitialArenaSize);
+}
+
+/**
+ *  Train a tree on the samples. The arena is sized up front for the number
+ *  of nodes expected, usually the whole tree fits in its first block.
+ */
+template <typename SplitCandidate, typename Distribution,
+          typename InputIterator,
+          typename TrainingExample = typename InputIterator::value_type,
+          typename Data = typename TrainingExample::first_type>
+Tree<Data, Distribution> growTree(InputIterator begin, InputIterator end,
+                                  TreeParameters const& conf, ThreadPool& pool,
+                                  Random rng) {
+  using Leaf = LeafNode<Data, Distribution>;
+  using Split = SplitNode<Data, SplitCandidate, Distribution>;
+
+  const auto samples = static_cast<size_t>(std::distance(begin, end));
+  auto arena = std::make_unique<Arena>(
+      initialArenaSize(samples, conf, sizeof(Leaf) + sizeof(Split)));
+  auto root = conf.trainingMode == TrainingMode::BREADTH_FIRST
+                  ? trainLevels<SplitCandidate, Distribution>(
+                        begin, end, conf, pool, rng, *arena)
+                  : trainNode<SplitCandidate, Distribution>(
+                        begin, end, conf, 0, pool, rng, *arena,
+                        LabelHistogram{begin, end});
+  return Tree<Data, Distribution>{std::move(arena), root};
+}
+
 }  // namespace impl
 
-template <typename SplitCandidate, typename InputData>
-Tree<InputData> trainTree(TrainSet<InputData>& train,
-                          TrainSet<InputData>& validation,
-                          TreeParameters stoppingCriteria) {
-  auto samples = train.sample();
+template <typename SplitCandidate, typename Distribution, typename InputData>
+Tree<InputData, Distribution> trainTree(TrainSet<InputData>& train,
+                                        TrainSet<InputData>& validation,
+                                        TreeParameters stoppingCriteria) {
+  ThreadPool pool{stoppingCriteria.numberOfThreads};
+  return trainTree<SplitCandidate, Distribution>(train, validation,
+                                                 stoppingCriteria, pool);
+}
+
+template <typename SplitCandidate, typename Distribution, typename InputData>
+Tree<InputData, Distribution> trainTree(TrainSet<InputData>& train,
+                                        TrainSet<InputData>& validation,
+                                        TreeParameters stoppingCriteria,
+                                        ThreadPool& pool) {
+  Random rng{stoppingCriteria.seed};
+  auto samples = train.sample(rng);
   // stop building tree
-  return impl::trainNode<SplitCandidate>(samples.begin(), samples.end(),
-                                         stoppingCriteria, 0);
+  auto tree = impl::growTree<SplitCandidate, Distribution>(
+      samples.begin(), samples.end(), stoppingCriteria, pool, Random{rng()});
+  train.release(samples);
+  return tree;
 }
 
 template <typename Classifier, typename Data>
@@ -124,7 +776,7 @@ double evaluateTree(Classifier const& tree, rf::TrainSet<Data>& test) {
     }
 
     auto const& trainExample = value.value();
-    auto const dist = tree.classify(trainExample.first);
+    auto const& dist = tree.classify(trainExample.first);
 
     const auto maxElement = dist.maxProb();
     if (maxElement.first != trainExample.second) {
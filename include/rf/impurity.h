@@ -0,0 +1,86 @@
+#pragma once
+
+#include <rf/parameters.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace rf {
+
+/**
+ *  Counts below this size get x * log(x) from a table
+ */
+constexpr size_t kXlogxTableSize = size_t{1} << 16;
+
+namespace impl {
+
+/**
+ *  Table of x * log(x) for x in [0, kXlogxTableSize), built on first use
+ */
+[[nodiscard]] double const* xlogxTable() noexcept;
+
+}  // namespace impl
+
+[[nodiscard]] inline double xlogx(uint32_t x) noexcept {
+  return x < kXlogxTableSize ? impl::xlogxTable()[x]
+                             : x * std::log(static_cast<double>(x));
+}
+
+/**
+ *  Impurity kernels over arrays of label counts, `total` being their sum.
+ *  With RF_HAVE_AVX2 they use AVX2 when the CPU running them supports it.
+ */
+
+/**
+ *  sum(c * log(c)), the part of the entropy that depends on the counts
+ */
+[[nodiscard]] double sumXlogx(uint32_t const* counts, size_t size) noexcept;
+
+/**
+ *  sum(c * c), the part of the Gini impurity that depends on the counts
+ */
+[[nodiscard]] double sumSquares(uint32_t const* counts, size_t size) noexcept;
+
+/**
+ *  H = log(N) - sum(c * log(c)) / N
+ */
+[[nodiscard]] double entropy(uint32_t const* counts, size_t size,
+                             uint32_t total) noexcept;
+
+/**
+ *  G = 1 - sum(c * c) / (N * N)
+ */
+[[nodiscard]] double gini(uint32_t const* counts, size_t size,
+                          uint32_t total) noexcept;
+
+/**
+ *  Sum of the criterion, sumXlogx or sumSquares
+ */
+[[nodiscard]] inline double impuritySum(uint32_t const* counts, size_t size,
+                                        SplitCriterion criterion) noexcept {
+  return criterion == SplitCriterion::GINI ? sumSquares(counts, size)
+                                           : sumXlogx(counts, size);
+}
+
+[[nodiscard]] inline double impurity(uint32_t const* counts, size_t size,
+                                     uint32_t total,
+                                     SplitCriterion criterion) noexcept {
+  return criterion == SplitCriterion::GINI ? gini(counts, size, total)
+                                           : entropy(counts, size, total);
+}
+
+/**
+ *  N times the impurity of a side with N samples, given the sum computed by
+ *  the kernel of the criterion. The sweeps update that sum incrementally.
+ */
+[[nodiscard]] inline double weightedImpurity(uint32_t total, double sum,
+                                             SplitCriterion criterion) noexcept {
+  if (total == 0) {
+    return 0.0;
+  }
+  return criterion == SplitCriterion::GINI ? total - sum / total
+                                           : xlogx(total) - sum;
+}
+
+}  // namespace rf
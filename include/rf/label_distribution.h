@@ -37,6 +37,21 @@ class LabelDistribution {
    */
   [[nodiscard]] std::pair<Label, double> maxProb() const noexcept;
 
+  /**
+   *  Return the probability of a label, zero if it was never seen.
+   */
+  [[nodiscard]] double probability(Label label) const noexcept;
+
+  /**
+   *  Call `f(label, probability)` for every label in the distribution.
+   */
+  template <typename Function>
+  void forEach(Function&& f) const {
+    for (auto const& p : dist_) {
+      f(p.first, p.second);
+    }
+  }
+
  private:
   void updateMaxProb() noexcept;
   std::pair<Label, double> maxProb_{0, 0.0};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <rf/impurity.h>
+#include <rf/label.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace rf {
+
+/**
+ *  Number of different values a Label can take
+ */
+constexpr size_t kMaxLabels = size_t{std::numeric_limits<Label>::max()} + 1;
+
+/**
+ *  Number of samples of each label in a set of training examples.
+ *
+ *  Unlike LabelDistribution it has a fixed size and never allocates, it is
+ *  meant to be filled in the inner loops of the training.
+ */
+class LabelHistogram {
+ public:
+  LabelHistogram() = default;
+
+  /**
+   *  Convenient constructor to count the labels of a sequence of training
+   *  examples
+   */
+  template <typename InputIterator>
+  LabelHistogram(InputIterator begin, InputIterator end) noexcept {
+    for (auto it = begin; it != end; ++it) {
+      add(static_cast<Label>(it->second));
+    }
+  }
+
+  void add(Label label, uint32_t n = 1) noexcept {
+    counts_[label] += n;
+    total_ += n;
+  }
+
+  LabelHistogram& operator+=(LabelHistogram const& other) noexcept;
+  LabelHistogram& operator-=(LabelHistogram const& other) noexcept;
+
+  [[nodiscard]] uint32_t count(Label label) const noexcept {
+    return counts_[label];
+  }
+  [[nodiscard]] uint32_t total() const noexcept { return total_; }
+
+  /**
+   *  Entropy of the label distribution given by the counts.
+   */
+  [[nodiscard]] double entropy() const noexcept {
+    return rf::entropy(counts_.data(), counts_.size(), total_);
+  }
+
+  [[nodiscard]] double gini() const noexcept {
+    return rf::gini(counts_.data(), counts_.size(), total_);
+  }
+
+  [[nodiscard]] double impurity(SplitCriterion criterion) const noexcept {
+    return rf::impurity(counts_.data(), counts_.size(), total_, criterion);
+  }
+
+ private:
+  std::array<uint32_t, kMaxLabels> counts_{};
+  uint32_t total_{0};
+};
+
+inline LabelHistogram operator-(LabelHistogram lhs,
+                                LabelHistogram const& rhs) noexcept {
+  return lhs -= rhs;
+}
+
+}  // namespace rf
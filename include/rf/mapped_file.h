@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace rf {
+
+/**
+ *  Read-only memory mapping of a whole file.
+ *
+ *  The mapping is shared, processes mapping the same file use the same pages
+ *  of the page cache.
+ */
+class MappedFile {
+ public:
+  /**
+   *  Throws std::system_error if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(std::string const& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  [[nodiscard]] std::byte const* data() const noexcept { return data_; }
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+
+ private:
+  std::byte const* data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace rf
@@ -1,14 +1,69 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 
 namespace rf {
 
+class TrainingObserver;
+
+enum class TrainingMode : uint8_t {
+  // Recursive, a node and its subtree at a time
+  DEPTH_FIRST = 0,
+  // One depth level at a time, all the nodes of the level are trained
+  // together
+  BREADTH_FIRST = 1,
+};
+
+enum class ThresholdSearch : uint8_t {
+  // Every candidate is scored with its own threshold, plus the extra
+  // thresholds of thresholdsPerFeature
+  RANDOM = 0,
+  // Every threshold of a candidate is scored by sorting the responses, the
+  // candidate gets the best one
+  SWEEP = 1,
+  // Like SWEEP over the boundaries of histogramBins quantile bins instead of
+  // every response, approximate but without sorting
+  HISTOGRAM = 2,
+};
+
+enum class SplitCriterion : uint8_t {
+  // Information gain
+  ENTROPY = 0,
+  // Decrease of the Gini impurity, cheaper than the entropy
+  GINI = 1,
+};
+
 struct TreeParameters {
   size_t numberOfTrees;
   size_t minSamplesPerNode;
   size_t maxDepth;
   size_t candidatesToGeneratePerNode;
+  // Impurity measure the candidates are scored with
+  SplitCriterion criterion{SplitCriterion::ENTROPY};
+  // How the thresholds of the candidates with a FeatureResponse are found
+  ThresholdSearch thresholdSearch{ThresholdSearch::RANDOM};
+  // Thresholds tried for every generated candidate by the RANDOM search
+  size_t thresholdsPerFeature{1};
+  // Bins of the HISTOGRAM search
+  size_t histogramBins{64};
+
+  // Threads used for training, 0 means one per hardware thread
+  size_t numberOfThreads{0};
+  // Nodes with fewer samples than this are trained on a single thread
+  size_t minSamplesPerTask{1000};
+  // Bytes of training samples held by the trees trained at the same time,
+  // 0 means no limit
+  size_t maxSampleMemory{0};
+
+  // Seed of all the random generators, the same seed trains the same trees
+  uint64_t seed{0};
+
+  // Both modes train the same trees
+  TrainingMode trainingMode{TrainingMode::DEPTH_FIRST};
+
+  // Receives the statistics of every node, nothing is measured when null
+  TrainingObserver* observer{nullptr};
 };
 
 }  // namespace rf
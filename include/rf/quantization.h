@@ -0,0 +1,84 @@
+#pragma once
+
+#include <rf/quantized_label_distribution.h>
+#include <rf/random_forest.h>
+#include <rf/train_set.h>
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace rf {
+
+namespace impl {
+
+template <typename SplitCandidate, typename = void>
+struct QuantizedSplitOf {
+  using type = SplitCandidate;
+};
+
+template <typename SplitCandidate>
+struct QuantizedSplitOf<
+    SplitCandidate,
+    std::void_t<decltype(std::declval<SplitCandidate const&>().quantize())>> {
+  using type = decltype(std::declval<SplitCandidate const&>().quantize());
+};
+
+}  // namespace impl
+
+/**
+ *  Compact counterpart of a split candidate. A candidate opts in with a
+ *  member `quantize() const` returning another split candidate on the same
+ *  Input with smaller parameters, e.g. float16 thresholds; candidates
+ *  without one are kept as they are.
+ */
+template <typename SplitCandidate>
+using QuantizedSplit = typename impl::QuantizedSplitOf<SplitCandidate>::type;
+
+template <typename SplitCandidate, size_t NumLabels,
+          typename Probability = uint8_t>
+using QuantizedForest =
+    RandomForest<QuantizedSplit<SplitCandidate>,
+                 QuantizedLabelDistribution<NumLabels, Probability>>;
+
+/**
+ *  Copy of a trained forest with quantized split candidates and leaves. The
+ *  trees keep their shape, the result is an ordinary RandomForest that can
+ *  be saved and loaded. Throws std::invalid_argument if the forest predicts
+ *  labels from NumLabels up.
+ */
+template <size_t NumLabels, typename Probability = uint8_t,
+          typename SplitCandidate, typename Distribution>
+QuantizedForest<SplitCandidate, NumLabels, Probability> quantizeForest(
+    RandomForest<SplitCandidate, Distribution> const& forest);
+
+/**
+ *  Bytes of the node and leaf arrays of every tree. Distributions owning
+ *  memory, like LabelDistribution, take more than reported.
+ */
+template <typename SplitCandidate, typename Distribution>
+size_t modelMemory(RandomForest<SplitCandidate, Distribution> const& forest);
+
+struct QuantizationReport {
+  size_t memory{0};
+  size_t quantizedMemory{0};
+  // classification error
+  double error{0.0};
+  double quantizedError{0.0};
+  // fraction of the inputs both forests give the same label
+  double agreement{0.0};
+};
+
+/**
+ *  Classify the test set with both forests to measure what the quantization
+ *  costs. Both go through classifyBatch(), which combines the leaves in
+ *  double precision as the deployed forests are.
+ */
+template <typename Forest, typename Quantized, typename Data>
+QuantizationReport compareQuantized(Forest const& forest,
+                                    Quantized const& quantized,
+                                    TrainSet<Data>& test);
+
+}  // namespace rf
+
+#include "impl/quantization.hpp"
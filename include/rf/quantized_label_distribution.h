@@ -0,0 +1,74 @@
+#pragma once
+
+#include <rf/half.h>
+#include <rf/label.h>
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace rf {
+
+/**
+ *  Inference only label distribution storing every probability in a single
+ *  `Probability`: uint8_t holds multiples of 1/255 and Half a float16. A leaf
+ *  of a few labels takes a few bytes instead of the doubles of
+ *  DenseLabelDistribution, so many more trees fit in cache.
+ *
+ *  The probabilities are rounded when quantizing and again every time two
+ *  distributions are combined, RandomForest::classifyBatch() combines the
+ *  leaves in double precision instead.
+ */
+template <size_t NumLabels, typename Probability = uint8_t>
+class QuantizedLabelDistribution {
+  static_assert(NumLabels > 0, "a distribution needs at least one label");
+  static_assert(std::is_same_v<Probability, uint8_t> ||
+                    std::is_same_v<Probability, Half>,
+                "probabilities are stored as uint8_t or Half");
+
+ public:
+  QuantizedLabelDistribution() = default;
+
+  /**
+   *  Round the probabilities of any distribution, labels from NumLabels up
+   *  are dropped.
+   */
+  template <typename Distribution>
+  explicit QuantizedLabelDistribution(Distribution const& dist);
+
+  QuantizedLabelDistribution& combine(
+      QuantizedLabelDistribution const& other) noexcept;
+
+  /**
+   *  Return the <label, prob> pair with max probability, the lowest label
+   *  on ties.
+   */
+  [[nodiscard]] std::pair<Label, double> maxProb() const noexcept;
+
+  [[nodiscard]] double probability(Label label) const noexcept {
+    return label < NumLabels ? dequantize(prob_[label]) : 0.0;
+  }
+
+  /**
+   *  Call `f(label, probability)` for every label in the distribution.
+   */
+  template <typename Function>
+  void forEach(Function&& f) const {
+    for (size_t i = 0; i < NumLabels; ++i) {
+      f(static_cast<Label>(i), dequantize(prob_[i]));
+    }
+  }
+
+  [[nodiscard]] static constexpr size_t size() noexcept { return NumLabels; }
+
+ private:
+  static Probability quantize(double p) noexcept;
+  static double dequantize(Probability p) noexcept;
+
+  std::array<Probability, NumLabels> prob_{};
+};
+
+}  // namespace rf
+
+#include "impl/quantized_label_distribution.hpp"
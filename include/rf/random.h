@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace rf {
+
+/**
+ *  xoshiro256** pseudo random generator.
+ *
+ *  It is much cheaper to seed and to run than std::mt19937 and satisfies
+ *  UniformRandomBitGenerator, so it works with the <random> distributions.
+ *  The training gives every tree and every node its own generator, seeded
+ *  from its parent's, so the result only depends on the initial seed and not
+ *  on how the work is scheduled.
+ */
+class Random {
+ public:
+  using result_type = uint64_t;
+
+  /**
+   *  The state is filled with splitmix64, any seed gives a usable state.
+   */
+  explicit Random(uint64_t seed = 0) noexcept {
+    for (auto& s : state_) {
+      seed += 0x9e3779b97f4a7c15;
+      auto z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  static constexpr result_type min() noexcept { return 0; }
+  static constexpr result_type max() noexcept {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() noexcept {
+    const auto result = rotl(state_[1] * 5, 7) * 9;
+    const auto t = state_[1] << 17;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+
+    return result;
+  }
+
+ private:
+  static constexpr uint64_t rotl(uint64_t x, int k) noexcept {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t state_[4]{};
+};
+
+}  // namespace rf
@@ -1,35 +1,346 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "flat_tree.h"
+#include "span.h"
 #include "tree.h"
 
 namespace rf {
 
-template <typename SplitCandidate>
+template <typename SplitCandidate, typename Distribution = LabelDistribution>
 class RandomForest {
   using Data = typename SplitCandidate::Input;
+  using Samples = std::vector<TrainingExample<Data>>;
 
  public:
   RandomForest() = default;
 
+  /**
+   *  Forest made of already trained trees, e.g. loaded from a file.
+   */
+  explicit RandomForest(
+      std::vector<FlatTree<SplitCandidate, Distribution>>&& trees)
+      : forest_{std::move(trees)}, numberOfLabels_{countLabels()} {}
+
+  RandomForest(std::vector<FlatTree<SplitCandidate, Distribution>>&& trees,
+               size_t numberOfLabels)
+      : forest_{std::move(trees)}, numberOfLabels_{numberOfLabels} {}
+
   void train(TrainSet<Data>& train, TrainSet<Data>& validation,
              TreeParameters const& params) {
+    ThreadPool pool{params.numberOfThreads};
+    this->train(train, validation, params, pool);
+  }
+
+  /**
+   *  Train the trees in parallel on the given pool.
+   *
+   *  Every tree is trained with its own call to TrainSet::sample(). The
+   *  samples are taken on the calling thread, which waits, running pending
+   *  tasks, while the samples of the trees in flight would exceed
+   *  `params.maxSampleMemory`. Once a tree is sampled, TrainSet::prefetch()
+   *  gets the generator of the next one.
+   *
+   *  If a tree throws no other tree is sampled, the exception is rethrown
+   *  once the trees in flight are done and every sample is released.
+   */
+  void train(TrainSet<Data>& train, TrainSet<Data>& validation,
+             TreeParameters const& params, ThreadPool& pool) {
     forest_.clear();
+    forest_.resize(params.numberOfTrees);
+
+    // samples of the trees already trained, waiting to be released
+    std::mutex finishedMutex{};
+    std::vector<Samples> finished{};
+    size_t memoryInFlight = 0;
+    // set by a tree that threw, no more trees are sampled then
+    std::atomic<bool> failed{false};
+
+    auto releaseFinished = [&] {
+      std::vector<Samples> samples{};
+      {
+        std::lock_guard<std::mutex> lock{finishedMutex};
+        samples.swap(finished);
+      }
+      for (auto& sample : samples) {
+        memoryInFlight -= sampleMemory(sample);
+        train.release(sample);
+      }
+    };
+
+    // every tree gets a generator seeded from this one, in order
+    Random forestRng{params.seed};
+
+    TaskGroup trees{pool};
+    size_t expectedMemory = 0;
     for (size_t i = 0; i < params.numberOfTrees; ++i) {
-      forest_.emplace_back(
-          trainTree<SplitCandidate>(train, validation, params));
+      // the next sample is expected to be as large as the previous one
+      while (!failed.load(std::memory_order_relaxed)) {
+        releaseFinished();
+        if (params.maxSampleMemory == 0 || memoryInFlight == 0 ||
+            memoryInFlight + expectedMemory <= params.maxSampleMemory) {
+          break;
+        }
+        if (!pool.runPendingTask()) {
+          std::this_thread::yield();
+        }
+      }
+      if (failed.load(std::memory_order_relaxed)) {
+        break;
+      }
+
+      Random rng{forestRng()};
+      auto samples = train.sample(rng);
+      expectedMemory = sampleMemory(samples);
+      memoryInFlight += expectedMemory;
+      if (i + 1 < params.numberOfTrees) {
+        prefetchNext(train, forestRng);
+      }
+
+      trees.run([this, i, &params, &pool, &finishedMutex, &finished,
+                 &failed, samples = std::move(samples),
+                 seed = rng()]() mutable {
+        // the samples are handed back even if the tree throws, the loop
+        // above waits for their memory
+        auto handOff = [&] {
+          std::lock_guard<std::mutex> lock{finishedMutex};
+          finished.emplace_back(std::move(samples));
+        };
+
+        try {
+          auto tree = impl::growTree<SplitCandidate, Distribution>(
+              samples.begin(), samples.end(), params, pool, Random{seed});
+          forest_[i] = compileTree<SplitCandidate>(tree);
+        } catch (...) {
+          failed.store(true, std::memory_order_relaxed);
+          handOff();
+          throw;
+        }
+        handOff();
+      });
     }
+
+    try {
+      trees.wait();
+    } catch (...) {
+      releaseFinished();
+      throw;
+    }
+    releaseFinished();
+
+    numberOfLabels_ = countLabels();
   }
 
-  [[nodiscard]] LabelDistribution classify(Data const& d) const noexcept {
-    LabelDistribution dist{};
+  void train(StreamingTrainSet<Data>& train, TreeParameters const& params) {
+    ThreadPool pool{params.numberOfThreads};
+    this->train(train, params, pool);
+  }
+
+  /**
+   *  Train the trees one after the other on examples streamed from the train
+   *  set, the pool is used within every tree. At most
+   *  `params.maxSampleMemory` bytes of chunks are loaded at the same time,
+   *  including the hinted chunk and StreamingTrainSet::prefetchMemory().
+   *  The trees are the same as when trained one by one with trainTree().
+   *  The next tree is prefetched while one trains, as for TrainSet.
+   */
+  void train(StreamingTrainSet<Data>& train, TreeParameters const& params,
+             ThreadPool& pool) {
+    forest_.clear();
+    forest_.reserve(params.numberOfTrees);
+
+    Random forestRng{params.seed};
+    for (size_t i = 0; i < params.numberOfTrees; ++i) {
+      Random rng{forestRng()};
+      train.sample(rng);
+      if (i + 1 < params.numberOfTrees) {
+        prefetchNext(train, forestRng);
+      }
+      auto tree = impl::growStreamingTree<SplitCandidate, Distribution>(
+          train, params, pool, Random{rng()});
+      forest_.emplace_back(compileTree<SplitCandidate>(tree));
+    }
+
+    numberOfLabels_ = countLabels();
+  }
+
+  [[nodiscard]] Distribution classify(Data const& d) const noexcept {
+    Distribution dist{};
     for (const auto& tree : forest_) {
       dist.combine(tree.classify(d));
     }
     return dist;
   }
 
+  /**
+   *  Classify a batch of inputs, writing the label with the highest
+   *  probability for each one into `labels`. Throws std::invalid_argument
+   *  unless it has the same size as `data`.
+   *
+   *  The inputs are processed in blocks and every block goes through one tree
+   *  at a time, so the tree stays in cache. The probabilities are combined
+   *  the same way classify() does. Nothing is allocated per input.
+   */
+  void classifyBatch(Span<const Data> data, Span<Label> labels) const {
+    classifyBlocks(data, Span<double>{}, labels, Output::LABELS, nullptr);
+  }
+
+  void classifyBatch(Span<const Data> data, Span<Label> labels,
+                     ThreadPool& pool) const {
+    classifyBlocks(data, Span<double>{}, labels, Output::LABELS, &pool);
+  }
+
+  /**
+   *  Classify a batch of inputs writing the probability of every label. The
+   *  scores are stored one row per input with `scores.size() / data.size()`
+   *  labels each, labels that do not fit are dropped. Throws
+   *  std::invalid_argument unless `scores` has at least one label per input
+   *  and is a multiple of the size of `data`.
+   */
+  void classifyBatch(Span<const Data> data, Span<double> scores) const {
+    classifyBlocks(data, scores, Span<Label>{}, Output::SCORES, nullptr);
+  }
+
+  void classifyBatch(Span<const Data> data, Span<double> scores,
+                     ThreadPool& pool) const {
+    classifyBlocks(data, scores, Span<Label>{}, Output::SCORES, &pool);
+  }
+
+  [[nodiscard]] std::vector<FlatTree<SplitCandidate, Distribution>> const&
+  trees() const noexcept {
+    return forest_;
+  }
+
+  /**
+   *  One more than the largest label any tree can predict.
+   */
+  [[nodiscard]] size_t numberOfLabels() const noexcept {
+    return numberOfLabels_;
+  }
+
  private:
-  std::vector<Tree<Data>> forest_{};
+  static constexpr size_t kBatchBlockSize = 1024;
+
+  // result written by classifyBlocks()
+  enum class Output { LABELS, SCORES };
+
+  void classifyBlocks(Span<const Data> data, Span<double> scores,
+                      Span<Label> labels, Output output,
+                      ThreadPool* pool) const {
+    const bool validSize =
+        output == Output::LABELS
+            ? labels.size() == data.size()
+            : (data.empty() ? scores.empty()
+                            : !scores.empty() &&
+                                  scores.size() % data.size() == 0);
+    if (!validSize) {
+      throw std::invalid_argument("output size does not match the input");
+    }
+
+    if (data.empty()) {
+      return;
+    }
+
+    const auto rowSize = output == Output::LABELS
+                             ? numberOfLabels_
+                             : scores.size() / data.size();
+
+    auto classifyBlock = [&](size_t first) {
+      const auto count = std::min(kBatchBlockSize, data.size() - first);
+      auto block = data.subspan(first, count);
+
+      if (output == Output::SCORES) {
+        scoreBlock(block, scores.subspan(first * rowSize, count * rowSize));
+        return;
+      }
+
+      std::vector<double> blockScores(count * rowSize);
+      scoreBlock(block, Span<double>{blockScores});
+      for (size_t i = 0; i < count; ++i) {
+        auto row = blockScores.begin() + i * rowSize;
+        labels[first + i] =
+            static_cast<Label>(std::max_element(row, row + rowSize) - row);
+      }
+    };
+
+    if (pool == nullptr || data.size() <= kBatchBlockSize) {
+      for (size_t first = 0; first < data.size(); first += kBatchBlockSize) {
+        classifyBlock(first);
+      }
+      return;
+    }
+
+    TaskGroup blocks{*pool};
+    for (size_t first = 0; first < data.size(); first += kBatchBlockSize) {
+      blocks.run([&classifyBlock, first] { classifyBlock(first); });
+    }
+    blocks.wait();
+  }
+
+  /**
+   *  Same combination as classify(): the first tree sets the scores, every
+   *  other one is averaged with the scores so far. Each tree finds the leaves
+   *  of the whole block at once with FlatTree::leafIndices().
+   */
+  void scoreBlock(Span<const Data> data, Span<double> scores) const {
+    using Index = typename FlatTree<SplitCandidate, Distribution>::Index;
+
+    const auto rowSize = data.empty() ? 0 : scores.size() / data.size();
+    std::fill(scores.begin(), scores.end(), 0.0);
+    std::vector<Index> leaves(data.size());
+
+    for (size_t t = 0; t < forest_.size(); ++t) {
+      const double weight = t == 0 ? 1.0 : 0.5;
+      forest_[t].leafIndices(data, Span<Index>{leaves});
+      for (size_t i = 0; i < data.size(); ++i) {
+        auto row = scores.data() + i * rowSize;
+        for (size_t l = 0; l < rowSize; ++l) {
+          row[l] *= weight;
+        }
+
+        forest_[t].leaves()[leaves[i]].forEach([row, rowSize, weight](
+                                                   Label label, double p) {
+          if (label < rowSize) {
+            row[label] += weight * p;
+          }
+        });
+      }
+    }
+  }
+
+  [[nodiscard]] size_t countLabels() const {
+    size_t count = 0;
+    for (auto const& tree : forest_) {
+      for (auto const& leaf : tree.leaves()) {
+        leaf.forEach([&count](Label label, double p) {
+          if (p > 0.0) {
+            count = std::max(count, size_t{label} + 1);
+          }
+        });
+      }
+    }
+    return count;
+  }
+
+  /**
+   *  Let the train set load what the next tree samples, with the generator
+   *  that tree gets.
+   */
+  template <typename Set>
+  static void prefetchNext(Set& train, Random forestRng) {
+    train.prefetch(Random{forestRng()});
+  }
+
+  static size_t sampleMemory(Samples const& samples) noexcept {
+    return samples.capacity() * sizeof(typename Samples::value_type);
+  }
+
+  std::vector<FlatTree<SplitCandidate, Distribution>> forest_{};
+  size_t numberOfLabels_{0};
 };
 
 }  // namespace rf
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <rf/random_forest.h>
+
+#include <ostream>
+#include <string>
+
+namespace rf {
+
+/**
+ *  Binary on-disk format of a trained forest.
+ *
+ *  The file starts with a FileHeader followed by one TreeHeader per tree.
+ *  Every tree then stores its FlatTree nodes and leaves exactly as they are
+ *  laid out in memory, each array starting at a multiple of kAlignment. This
+ *  is what allows loadForest to map the file and use it in place.
+ *
+ *  Files can only be loaded on a machine with the same byte order and by a
+ *  program with the same SplitCandidate and Distribution layouts, the header
+ *  records enough to detect a mismatch.
+ */
+namespace format {
+
+constexpr char kMagic[8] = {'R', 'G', 'B', 'D', '-', 'R', 'F', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kByteOrder = 0x01020304;
+constexpr size_t kAlignment = 64;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t splitVersion;
+  uint32_t nodeSize;
+  uint32_t leafSize;
+  uint32_t numberOfLabels;
+  uint64_t numberOfTrees;
+};
+
+struct TreeHeader {
+  uint64_t nodesOffset;
+  uint64_t nodeCount;
+  uint64_t leavesOffset;
+  uint64_t leafCount;
+  uint32_t root;
+  uint32_t reserved;
+};
+
+}  // namespace format
+
+/**
+ *  Write a trained forest. Throws std::runtime_error if the stream fails.
+ */
+template <typename SplitCandidate, typename Distribution>
+void saveForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                std::ostream& os);
+
+template <typename SplitCandidate, typename Distribution>
+void saveForest(RandomForest<SplitCandidate, Distribution> const& forest,
+                std::string const& path);
+
+/**
+ *  Memory-map a forest saved with saveForest. Nothing is parsed or copied,
+ *  the trees read the mapped file directly and keep it mapped for as long as
+ *  any of them is alive.
+ *
+ *  Throws std::system_error if the file cannot be mapped and
+ *  std::runtime_error if it is not a compatible forest, including split
+ *  candidates that are not SplitCandidate::valid().
+ */
+template <typename SplitCandidate, typename Distribution>
+RandomForest<SplitCandidate, Distribution> loadForest(std::string const& path);
+
+}  // namespace rf
+
+#include "impl/serialization.hpp"
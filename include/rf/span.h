@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace rf {
+
+/**
+ *  Non owning view over a contiguous sequence, a minimal stand-in for the
+ *  C++20 std::span.
+ */
+template <typename T>
+class Span {
+ public:
+  using value_type = std::remove_cv_t<T>;
+
+  Span() = default;
+  Span(T* data, size_t size) noexcept : data_{data}, size_{size} {}
+
+  /**
+   *  View over any container with contiguous storage, e.g. std::vector.
+   */
+  template <typename Container,
+            typename = std::enable_if_t<std::is_convertible_v<
+                decltype(std::declval<Container&>().data()), T*>>>
+  Span(Container& container) noexcept
+      : data_{container.data()}, size_{container.size()} {}
+
+  [[nodiscard]] T* data() const noexcept { return data_; }
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] T* begin() const noexcept { return data_; }
+  [[nodiscard]] T* end() const noexcept { return data_ + size_; }
+
+  [[nodiscard]] T& operator[](size_t i) const noexcept { return data_[i]; }
+
+  [[nodiscard]] Span subspan(size_t offset, size_t count) const noexcept {
+    return Span{data_ + offset, count};
+  }
+
+ private:
+  T* data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace rf
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <rf/random.h>
+
+#include <cstdint>
+
 namespace rf {
 
 enum class SplitResult : uint8_t {
@@ -16,7 +20,29 @@ class SplitCandidate {
     return static_cast<Derived const&>(*this)(d);
   }
 
-  static SplitCandidate generate() { return Derived::generate(); }
+  /**
+   *  Generate a random candidate. The generator is owned by the node being
+   *  trained, a candidate must not use any other source of randomness for the
+   *  training to be reproducible.
+   */
+  static Derived generate(Random& rng) { return Derived::generate(rng); }
+
+  /**
+   *  Serialization hook. Saved forests store the split candidates with their
+   *  in-memory representation so they can be memory-mapped, which requires
+   *  the derived class to be trivially copyable. The version is stored in the
+   *  file and checked on load: derived classes should define their own and
+   *  bump it whenever their members change.
+   */
+  static constexpr uint32_t serializationVersion() noexcept { return 0; }
+
+  /**
+   *  Loading hook. loadForest() maps the saved candidates without running
+   *  any constructor, derived classes relying on invariants their
+   *  constructor enforces should check them here, the file is rejected if
+   *  any candidate is not valid.
+   */
+  [[nodiscard]] bool valid() const noexcept { return true; }
 };
 
 }  // namespace rf
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <rf/label.h>
+#include <rf/random.h>
+#include <rf/span.h>
+#include <rf/train_set.h>
+
+#include <vector>
+
+namespace rf {
+
+/**
+ *  Training examples of a tree that do not have to fit in memory at once.
+ *
+ *  The examples drawn for a tree are split in chunks, e.g. the pixels sampled
+ *  from one image. Only the labels of all the examples are kept in memory,
+ *  the training loads a chunk when it needs its data and unloads it to stay
+ *  within TreeParameters::maxSampleMemory.
+ */
+template <typename Data>
+class StreamingTrainSet {
+ public:
+  using TrainingExampleType = TrainingExample<Data>;
+
+  virtual ~StreamingTrainSet() = default;
+
+  /**
+   *  Draw the training examples of one tree, replacing the previous ones.
+   *  All the randomness has to come from `rng` for the training to be
+   *  reproducible.
+   */
+  virtual void sample(Random& rng) = 0;
+
+  [[nodiscard]] virtual size_t chunks() const = 0;
+
+  /**
+   *  Labels of the examples of a chunk, available without loading it.
+   */
+  [[nodiscard]] virtual Span<const Label> labels(size_t chunk) const = 0;
+
+  /**
+   *  Examples of a chunk, in the order of labels(chunk). The data they refer
+   *  to stays valid until unload(chunk).
+   */
+  virtual std::vector<TrainingExampleType> load(size_t chunk) = 0;
+  virtual void unload(size_t chunk) = 0;
+
+  /**
+   *  Memory held by a loaded chunk, counted against the budget.
+   */
+  [[nodiscard]] virtual size_t chunkMemory(size_t chunk) const = 0;
+
+  /**
+   *  Called with a copy of the generator the next sample() gets, while the
+   *  current tree trains, to start loading the data it will draw.
+   */
+  virtual void prefetch(Random /*rng*/) {}
+
+  /**
+   *  Memory held by what prefetch() loaded ahead and sample() did not take
+   *  yet, counted against the budget of the tree in training.
+   */
+  [[nodiscard]] virtual size_t prefetchMemory() const { return 0; }
+
+  /**
+   *  Hint that load(chunk) comes next, to start loading it in the background
+   *  ahead of what prefetch() queued. The chunk is counted against the budget
+   *  from the hint on.
+   */
+  virtual void prefetchChunk(size_t /*chunk*/) {}
+};
+
+}  // namespace rf
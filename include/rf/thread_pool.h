@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rf {
+
+/**
+ *  Fixed size pool of worker threads used to train the trees.
+ *
+ *  Every worker owns a queue of tasks. Workers take the most recent task from
+ *  their own queue and steal the oldest task from the other queues when
+ *  theirs is empty. Threads that are not part of the pool share an extra
+ *  queue.
+ *
+ *  The thread that waits on a TaskGroup counts as one of the pool threads: it
+ *  runs pending tasks while it waits. Nested fork/join parallelism therefore
+ *  never has more than `size()` threads doing work.
+ */
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+   *  Create a pool that runs at most `numberOfThreads` tasks concurrently,
+   *  counting the waiting thread. Zero uses one thread per hardware thread.
+   */
+  explicit ThreadPool(size_t numberOfThreads = 0);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  /**
+   *  Number of threads that can run tasks concurrently.
+   */
+  [[nodiscard]] size_t size() const noexcept { return workers_.size() + 1; }
+
+  /**
+   *  Queue a task. Tasks submitted from a worker go to its own queue.
+   */
+  void submit(Task&& task);
+
+  /**
+   *  Run one pending task on the calling thread. Returns false if there was
+   *  no task to run.
+   */
+  bool runPendingTask();
+
+ private:
+  struct Queue {
+    std::mutex mutex{};
+    std::deque<Task> tasks{};
+  };
+
+  void workerLoop(size_t index);
+  [[nodiscard]] size_t currentQueue() const noexcept;
+  bool pop(size_t index, Task& task);
+
+  std::vector<std::unique_ptr<Queue>> queues_{};
+  std::vector<std::thread> workers_{};
+
+  std::mutex sleepMutex_{};
+  std::condition_variable wakeUp_{};
+  std::atomic<size_t> queued_{0};
+  bool stop_{false};
+};
+
+/**
+ *  A set of tasks running on a ThreadPool that can be waited for.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& pool) noexcept : pool_{pool} {}
+
+  TaskGroup(TaskGroup const&) = delete;
+  TaskGroup& operator=(TaskGroup const&) = delete;
+
+  /**
+   *  Waits for the remaining tasks, any exception they throw is dropped.
+   */
+  ~TaskGroup();
+
+  template <typename Function>
+  void run(Function&& function) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.submit([this, function = std::forward<Function>(function)]() mutable {
+      try {
+        function();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{errorMutex_};
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      pending_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  /**
+   *  Run pending tasks of the pool until all the tasks of the group are
+   *  finished. Rethrows the first exception thrown by a task.
+   */
+  void wait();
+
+ private:
+  ThreadPool& pool_;
+  std::atomic<size_t> pending_{0};
+  std::mutex errorMutex_{};
+  std::exception_ptr error_{nullptr};
+};
+
+}  // namespace rf
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <rf/label.h>
+#include <rf/label_histogram.h>
+#include <rf/parameters.h>
+#include <rf/span.h>
+
+#include <utility>
+#include <vector>
+
+namespace rf {
+
+struct ThresholdScore {
+  float threshold{0.0f};
+  // decrease of impurity, 0 when no threshold separates the samples
+  double gain{0.0};
+};
+
+/**
+ *  Find the threshold with the highest information gain for a feature.
+ *
+ *  `samples` holds the response and the label of every sample of the node,
+ *  `entireSet` their label counts. The samples are sorted by response and
+ *  swept once, keeping running counts of both sides, every boundary between
+ *  two different responses is scored. The threshold is halfway between the
+ *  responses of the boundary so that `response < threshold` sends the lower
+ *  ones to the left. NaN responses always go to the right.
+ */
+ThresholdScore sweepThresholds(
+    std::vector<std::pair<float, Label>>& samples,
+    LabelHistogram const& entireSet, double totalImpurity,
+    SplitCriterion criterion = SplitCriterion::ENTROPY);
+
+/**
+ *  Approximate sweepThresholds for large nodes, without sorting.
+ *
+ *  The responses are quantized into at most `bins` bins whose edges are
+ *  quantiles of a subsample of the responses, and the label counts of every
+ *  bin accumulated. The bin boundaries are then swept like the exact
+ *  version, the threshold is the edge of the best boundary. NaN responses
+ *  fall in the last bin, on the right of every threshold.
+ */
+ThresholdScore sweepBinnedThresholds(
+    Span<const float> responses, Span<const Label> labels,
+    LabelHistogram const& entireSet, double totalImpurity, size_t bins,
+    SplitCriterion criterion = SplitCriterion::ENTROPY);
+
+}  // namespace rf
@@ -1,5 +1,6 @@
 #pragma once
 #include <rf/label.h>
+#include <rf/random.h>
 
 #include <memory>
 #include <optional>
@@ -29,8 +30,26 @@ class TrainSet {
     virtual ~TrainSetIterator() {}
   };
 
-  virtual std::vector<TrainingExampleType> sample() = 0;
+  /**
+   *  Draw the training examples of one tree. All the randomness has to come
+   *  from `rng` for the training to be reproducible.
+   */
+  virtual std::vector<TrainingExampleType> sample(Random& rng) = 0;
   virtual std::unique_ptr<TrainSetIterator> iter() = 0;
+
+  /**
+   *  Called once a tree is trained with samples returned by sample(), e.g. to
+   *  free the data they refer to. When trees are trained in parallel several
+   *  samples are alive at the same time. sample() and release() are always
+   *  called from the thread that started the training.
+   */
+  virtual void release(std::vector<TrainingExampleType>& /*samples*/) {}
+
+  /**
+   *  Called with a copy of the generator the next sample() gets, while the
+   *  trees train, to start loading the data it will draw in the background.
+   */
+  virtual void prefetch(Random /*rng*/) {}
 };
 
 }  // namespace rf
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace rf {
+
+/**
+ *  Measurements of a split node, reported once its split is chosen. The
+ *  times do not include the training of the children.
+ */
+struct SplitStatistics {
+  size_t depth{0};
+  size_t samples{0};
+  // information gain of the chosen candidate
+  double gain{0.0};
+  // candidates without any gain, e.g. sending every sample to one side
+  size_t rejectedCandidates{0};
+  double generateSeconds{0.0};
+  double scoreSeconds{0.0};
+  double partitionSeconds{0.0};
+};
+
+struct LeafStatistics {
+  size_t depth{0};
+  size_t samples{0};
+  // includes the search of a split that was not used, e.g. when no candidate
+  // had any gain
+  double seconds{0.0};
+};
+
+/**
+ *  Interface to follow the training of the trees, set it in
+ *  TreeParameters::observer. Nodes are trained in parallel, implementations
+ *  have to be thread safe. Without an observer nothing is measured.
+ */
+class TrainingObserver {
+ public:
+  virtual ~TrainingObserver() = default;
+
+  virtual void onSplit(SplitStatistics const& split) = 0;
+  virtual void onLeaf(LeafStatistics const& leaf) = 0;
+};
+
+/**
+ *  Observer that aggregates the statistics of every depth, over all the
+ *  trees trained while it is attached.
+ */
+class TrainingStatistics : public TrainingObserver {
+ public:
+  struct Depth {
+    size_t splits{0};
+    size_t leaves{0};
+    size_t samples{0};
+    size_t minSamples{0};
+    size_t maxSamples{0};
+    double gainSum{0.0};
+    double maxGain{0.0};
+    size_t rejectedCandidates{0};
+    // time of the nodes summed, not the wall time of the depth: nodes and
+    // trees trained in parallel add up
+    double generateNodeSeconds{0.0};
+    double scoreNodeSeconds{0.0};
+    double partitionNodeSeconds{0.0};
+    double leafNodeSeconds{0.0};
+  };
+
+  void onSplit(SplitStatistics const& split) override;
+  void onLeaf(LeafStatistics const& leaf) override;
+
+  /**
+   *  Statistics indexed by depth.
+   */
+  [[nodiscard]] std::vector<Depth> depths() const;
+
+  void clear();
+
+  /**
+   *  Write the statistics as a JSON object with one entry per depth.
+   */
+  void writeJson(std::ostream& os) const;
+
+ private:
+  Depth& depth(size_t depth, size_t samples);
+
+  mutable std::mutex mutex_{};
+  std::vector<Depth> depths_{};
+};
+
+}  // namespace rf
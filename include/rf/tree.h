@@ -1,31 +1,54 @@
 #pragma once
 
+#include <rf/arena.h>
+#include <rf/dense_label_distribution.h>
+#include <rf/feature_response.h>
 #include <rf/label.h>
 #include <rf/label_distribution.h>
+#include <rf/label_histogram.h>
 #include <rf/parameters.h>
 #include <rf/split_candidate.h>
+#include <rf/streaming_train_set.h>
+#include <rf/thread_pool.h>
+#include <rf/threshold_sweep.h>
 #include <rf/train_set.h>
+#include <rf/training_statistics.h>
 
 #include <memory>
 
 namespace rf {
 
-template <typename Data>
+/**
+ *  The Distribution stored in the leaves can be any type with the interface
+ *  of LabelDistribution, e.g. DenseLabelDistribution when the number of
+ *  labels is known.
+ *
+ *  Nodes are allocated in the Arena of their tree and never deleted through
+ *  a base pointer, the destructor is not virtual so nodes with trivially
+ *  destructible members are trivially destructible too.
+ */
+template <typename Data, typename Distribution = LabelDistribution>
 class TreeNode {
  public:
-  virtual LabelDistribution classify(Data const&) const noexcept = 0;
-  virtual ~TreeNode() {}
+  virtual Distribution const& classify(Data const&) const noexcept = 0;
+
+ protected:
+  ~TreeNode() = default;
 };
 
-template <typename Data>
-using NodePtr = std::unique_ptr<TreeNode<Data>>;
+/**
+ *  Non owning, the nodes belong to the arena of the tree.
+ */
+template <typename Data, typename Distribution = LabelDistribution>
+using NodePtr = TreeNode<Data, Distribution>*;
 
-template <typename Data, typename SplitCandidate>
-class SplitNode : public TreeNode<Data> {
+template <typename Data, typename SplitCandidate,
+          typename Distribution = LabelDistribution>
+class SplitNode : public TreeNode<Data, Distribution> {
  public:
-  using Ptr = NodePtr<Data>;
+  using Ptr = NodePtr<Data, Distribution>;
 
-  LabelDistribution classify(Data const& data) const noexcept override {
+  Distribution const& classify(Data const& data) const noexcept override {
     if (split_.classify(data) == SplitResult::LEFT) {
       return left_->classify(data);
     } else {
@@ -37,8 +60,16 @@ class SplitNode : public TreeNode<Data> {
       std::is_nothrow_constructible_v<SplitCandidate>)
       : split_(std::move(split)) {}
 
-  void setLeftChild(Ptr&& left) { left_ = std::move(left); }
-  void setRightChild(Ptr&& right) { right_ = std::move(right); }
+  void setLeftChild(Ptr left) noexcept { left_ = left; }
+  void setRightChild(Ptr right) noexcept { right_ = right; }
+
+  [[nodiscard]] SplitCandidate const& split() const noexcept { return split_; }
+  [[nodiscard]] TreeNode<Data, Distribution> const* left() const noexcept {
+    return left_;
+  }
+  [[nodiscard]] TreeNode<Data, Distribution> const* right() const noexcept {
+    return right_;
+  }
 
  private:
   SplitCandidate split_;
@@ -46,10 +77,10 @@ class SplitNode : public TreeNode<Data> {
   Ptr right_{nullptr};
 };
 
-template <typename Data>
-class LeafNode : public TreeNode<Data> {
+template <typename Data, typename Distribution = LabelDistribution>
+class LeafNode : public TreeNode<Data, Distribution> {
  public:
-  LabelDistribution classify(Data const& data) const noexcept override {
+  Distribution const& classify(Data const& data) const noexcept override {
     return distribution_;
   }
 
@@ -57,30 +88,70 @@ class LeafNode : public TreeNode<Data> {
   LeafNode(InputIterator begin, InputIterator end)
       : distribution_{begin, end} {}
 
+  [[nodiscard]] Distribution const& distribution() const noexcept {
+    return distribution_;
+  }
+
  private:
-  LabelDistribution distribution_{};
+  Distribution distribution_{};
 };
 
-template <typename Data>
+template <typename Data, typename Distribution = LabelDistribution>
 class Tree {
  public:
-  LabelDistribution classify(Data const& data) const noexcept {
+  Distribution const& classify(Data const& data) const noexcept {
     return root_->classify(data);
   }
 
-  Tree(NodePtr<Data>&& root) noexcept : root_{std::move(root)} {}
+  /**
+   *  `root` and all its descendants have to be allocated in `arena`.
+   */
+  Tree(std::unique_ptr<Arena>&& arena,
+       NodePtr<Data, Distribution> root) noexcept
+      : arena_{std::move(arena)}, root_{root} {}
+
+  [[nodiscard]] TreeNode<Data, Distribution> const* root() const noexcept {
+    return root_;
+  }
 
  private:
-  NodePtr<Data> root_{nullptr};
+  std::unique_ptr<Arena> arena_{nullptr};
+  NodePtr<Data, Distribution> root_{nullptr};
 };
 
 /**
  *  Train a single decision tree.
  */
-template <typename SplitCandidate, typename InputData>
-Tree<InputData> trainTree(TrainSet<InputData>& train,
-                          TrainSet<InputData>& validation,
-                          TreeParameters stoppingCriteria);
+template <typename SplitCandidate, typename Distribution = LabelDistribution,
+          typename InputData>
+Tree<InputData, Distribution> trainTree(TrainSet<InputData>& train,
+                                        TrainSet<InputData>& validation,
+                                        TreeParameters stoppingCriteria);
+
+/**
+ *  Train a single decision tree running the work on the given pool.
+ */
+template <typename SplitCandidate, typename Distribution = LabelDistribution,
+          typename InputData>
+Tree<InputData, Distribution> trainTree(TrainSet<InputData>& train,
+                                        TrainSet<InputData>& validation,
+                                        TreeParameters stoppingCriteria,
+                                        ThreadPool& pool);
+
+/**
+ *  Train a single decision tree on examples that are streamed from the
+ *  train set chunk by chunk, see StreamingTrainSet.
+ */
+template <typename SplitCandidate, typename Distribution = LabelDistribution,
+          typename InputData>
+Tree<InputData, Distribution> trainTree(StreamingTrainSet<InputData>& train,
+                                        TreeParameters stoppingCriteria);
+
+template <typename SplitCandidate, typename Distribution = LabelDistribution,
+          typename InputData>
+Tree<InputData, Distribution> trainTree(StreamingTrainSet<InputData>& train,
+                                        TreeParameters stoppingCriteria,
+                                        ThreadPool& pool);
 
 /**
  *  Returns the classification error from the input set.
@@ -91,3 +162,4 @@ double evaluateTree(Classifier const& tree, rf::TrainSet<Data>& test);
 }  // namespace rf
 
 #include "impl/tree.hpp"
+#include "impl/streaming.hpp"
@@ -0,0 +1,23 @@
+#include <rf/arena.h>
+
+namespace rf {
+
+Arena::Arena(size_t initialSize) : memory_{initialSize} {}
+
+Arena::~Arena() {
+  for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+    it->second(it->first);
+  }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return memory_.allocate(size, alignment);
+}
+
+void Arena::addDestructor(void* object, Destructor destructor) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  destructors_.emplace_back(object, destructor);
+}
+
+}  // namespace rf
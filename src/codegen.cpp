@@ -0,0 +1,36 @@
+#include <rf/codegen.h>
+
+#include <cmath>
+#include <sstream>
+
+namespace rf {
+
+namespace {
+
+template <typename T>
+void writeFloatingPoint(std::ostream& os, T value, char const* type,
+                        char const* suffix) {
+  if (std::isnan(value)) {
+    os << "std::numeric_limits<" << type << ">::quiet_NaN()";
+  } else if (std::isinf(value)) {
+    os << (value < 0 ? "-" : "") << "std::numeric_limits<" << type
+       << ">::infinity()";
+  } else {
+    // a separate stream leaves the format flags of `os` alone
+    std::ostringstream literal{};
+    literal << std::hexfloat << value << suffix;
+    os << literal.str();
+  }
+}
+
+}  // namespace
+
+void writeLiteral(std::ostream& os, float value) {
+  writeFloatingPoint(os, value, "float", "f");
+}
+
+void writeLiteral(std::ostream& os, double value) {
+  writeFloatingPoint(os, value, "double", "");
+}
+
+}  // namespace rf
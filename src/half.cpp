@@ -0,0 +1,38 @@
+#include <rf/half.h>
+
+#include <cmath>
+
+namespace rf {
+
+uint16_t Half::fromFloat(float value) noexcept {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000u;
+  const uint32_t magnitude = bits & 0x7fffffffu;
+
+  // infinity and NaN, keeping NaN quiet
+  if (magnitude >= 0x7f800000u) {
+    return static_cast<uint16_t>(
+        sign | (magnitude > 0x7f800000u ? 0x7e00u : 0x7c00u));
+  }
+  // 65520 and above round to infinity
+  if (magnitude >= 0x477ff000u) {
+    return static_cast<uint16_t>(sign | 0x7c00u);
+  }
+  // below 2^-14 the result is subnormal, mantissa * 2^-24 rounded to even
+  if (magnitude < 0x38800000u) {
+    const auto mantissa = std::nearbyint(std::fabs(value) * 0x1p24f);
+    return static_cast<uint16_t>(sign | static_cast<uint32_t>(mantissa));
+  }
+
+  // drop 13 mantissa bits, a carry into the exponent is still correct
+  uint32_t half = ((magnitude >> 23) - 112) << 10 |
+                  ((magnitude >> 13) & 0x3ffu);
+  const uint32_t rest = magnitude & 0x1fffu;
+  if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+    ++half;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+}  // namespace rf
@@ -0,0 +1,171 @@
+#include <rf/impurity.h>
+
+#include <array>
+#include <memory>
+
+#ifdef RF_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace rf {
+
+namespace impl {
+
+double const* xlogxTable() noexcept {
+  static const auto table = [] {
+    auto table = std::make_unique<double[]>(kXlogxTableSize);
+    table[0] = 0.0;
+    for (size_t x = 1; x < kXlogxTableSize; ++x) {
+      table[x] = x * std::log(static_cast<double>(x));
+    }
+    return table;
+  }();
+  return table.get();
+}
+
+}  // namespace impl
+
+namespace {
+
+double sumXlogxScalar(uint32_t const* counts, size_t size) noexcept {
+  double sum = 0.0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += xlogx(counts[i]);
+  }
+  return sum;
+}
+
+double sumSquaresScalar(uint32_t const* counts, size_t size) noexcept {
+  double sum = 0.0;
+  for (size_t i = 0; i < size; ++i) {
+    const auto x = static_cast<double>(counts[i]);
+    sum += x * x;
+  }
+  return sum;
+}
+
+#ifdef RF_HAVE_AVX2
+
+// Only these functions are compiled for AVX2, they run if the CPU has it
+#define RF_AVX2 __attribute__((target("avx2")))
+
+RF_AVX2 double horizontalSum(__m256d v) noexcept {
+  const auto sum = _mm_add_pd(_mm256_castpd256_pd128(v),
+                              _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+RF_AVX2 double sumXlogxAvx2(uint32_t const* counts, size_t size) noexcept {
+  const auto* table = impl::xlogxTable();
+  const auto limit = _mm256_set1_epi32(static_cast<int>(kXlogxTableSize));
+  const auto zero = _mm256_setzero_si256();
+  // gather every lane, the masked gather has an explicit source
+  const auto all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+  auto sum = _mm256_setzero_pd();
+  double rest = 0.0;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const auto c =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(counts + i));
+
+    // counts out of the table are rare, compute them one by one. The
+    // comparison is signed, counts above INT_MAX look negative.
+    const auto small =
+        _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, c),
+                            _mm256_cmpgt_epi32(limit, c));
+    if (_mm256_movemask_epi8(small) != -1) {
+      for (size_t j = i; j < i + 8; ++j) {
+        rest += xlogx(counts[j]);
+      }
+      continue;
+    }
+
+    sum = _mm256_add_pd(
+        sum, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table,
+                                      _mm256_castsi256_si128(c), all, 8));
+    sum = _mm256_add_pd(
+        sum, _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table,
+                                      _mm256_extracti128_si256(c, 1), all, 8));
+  }
+
+  for (; i < size; ++i) {
+    rest += xlogx(counts[i]);
+  }
+
+  return horizontalSum(sum) + rest;
+}
+
+RF_AVX2 double sumSquaresAvx2(uint32_t const* counts, size_t size) noexcept {
+  auto sum = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const auto c =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(counts + i));
+    // the conversion is signed, counts above INT_MAX have to be wrapped back
+    const auto converted = _mm256_cvtepi32_pd(c);
+    const auto wrap = _mm256_and_pd(
+        _mm256_cmp_pd(converted, _mm256_setzero_pd(), _CMP_LT_OQ),
+        _mm256_set1_pd(4294967296.0));
+    const auto x = _mm256_add_pd(converted, wrap);
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(x, x));
+  }
+
+  double rest = 0.0;
+  for (; i < size; ++i) {
+    const auto x = static_cast<double>(counts[i]);
+    rest += x * x;
+  }
+
+  return horizontalSum(sum) + rest;
+}
+
+#undef RF_AVX2
+
+bool hasAvx2() noexcept {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return supported;
+}
+
+#endif
+
+}  // namespace
+
+double sumXlogx(uint32_t const* counts, size_t size) noexcept {
+#ifdef RF_HAVE_AVX2
+  if (hasAvx2()) {
+    return sumXlogxAvx2(counts, size);
+  }
+#endif
+  return sumXlogxScalar(counts, size);
+}
+
+double sumSquares(uint32_t const* counts, size_t size) noexcept {
+#ifdef RF_HAVE_AVX2
+  if (hasAvx2()) {
+    return sumSquaresAvx2(counts, size);
+  }
+#endif
+  return sumSquaresScalar(counts, size);
+}
+
+double entropy(uint32_t const* counts, size_t size, uint32_t total) noexcept {
+  if (total == 0) {
+    return 0.0;
+  }
+  return std::log(static_cast<double>(total)) -
+         sumXlogx(counts, size) / total;
+}
+
+double gini(uint32_t const* counts, size_t size, uint32_t total) noexcept {
+  if (total == 0) {
+    return 0.0;
+  }
+  const double n = total;
+  return 1.0 - sumSquares(counts, size) / (n * n);
+}
+
+}  // namespace rf
@@ -36,6 +36,11 @@ std::pair<Label, double> LabelDistribution::maxProb() const noexcept {
   return maxProb_;
 }
 
+double LabelDistribution::probability(Label label) const noexcept {
+  auto it = dist_.find(label);
+  return it != dist_.end() ? it->second : 0.0;
+}
+
 void LabelDistribution::updateMaxProb() noexcept {
   maxProb_ = *std::max_element(
       dist_.begin(), dist_.end(),
@@ -0,0 +1,23 @@
+#include <rf/label_histogram.h>
+
+namespace rf {
+
+LabelHistogram& LabelHistogram::operator+=(
+    LabelHistogram const& other) noexcept {
+  for (size_t i = 0; i < kMaxLabels; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  total_ += other.total_;
+  return *this;
+}
+
+LabelHistogram& LabelHistogram::operator-=(
+    LabelHistogram const& other) noexcept {
+  for (size_t i = 0; i < kMaxLabels; ++i) {
+    counts_[i] -= other.counts_[i];
+  }
+  total_ -= other.total_;
+  return *this;
+}
+
+}  // namespace rf
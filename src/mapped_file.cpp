@@ -0,0 +1,56 @@
+#include <rf/mapped_file.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace rf {
+
+namespace {
+
+[[noreturn]] void throwSystemError(int error, std::string const& what) {
+  throw std::system_error(error, std::generic_category(), what);
+}
+
+}  // namespace
+
+MappedFile::MappedFile(std::string const& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throwSystemError(errno, "cannot open " + path);
+  }
+
+  struct stat status {};
+  if (::fstat(fd, &status) != 0) {
+    // close() may overwrite errno
+    const int error = errno;
+    ::close(fd);
+    throwSystemError(error, "cannot stat " + path);
+  }
+
+  size_ = static_cast<size_t>(status.st_size);
+  if (size_ > 0) {
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      throwSystemError(error, "cannot map " + path);
+    }
+    data_ = static_cast<std::byte const*>(data);
+  }
+
+  // the mapping keeps the file referenced
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<std::byte*>(data_), size_);
+  }
+}
+
+}  // namespace rf
@@ -0,0 +1,142 @@
+#include <rf/thread_pool.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace rf {
+
+namespace {
+
+// Pool and queue of the worker running on this thread, if any
+thread_local ThreadPool const* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t numberOfThreads) {
+  if (numberOfThreads == 0) {
+    numberOfThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  // queue 0 is shared by the threads outside of the pool
+  for (size_t i = 0; i < numberOfThreads; ++i) {
+    queues_.emplace_back(std::make_unique<Queue>());
+  }
+
+  for (size_t i = 1; i < numberOfThreads; ++i) {
+    workers_.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{sleepMutex_};
+    stop_ = true;
+  }
+  wakeUp_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::currentQueue() const noexcept {
+  return currentPool == this ? currentIndex : 0;
+}
+
+void ThreadPool::submit(Task&& task) {
+  {
+    std::lock_guard<std::mutex> lock{sleepMutex_};
+    queued_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  auto& queue = *queues_[currentQueue()];
+  {
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    queue.tasks.emplace_back(std::move(task));
+  }
+
+  wakeUp_.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+  Task task{};
+  if (!pop(currentQueue(), task)) {
+    return false;
+  }
+
+  task();
+  return true;
+}
+
+bool ThreadPool::pop(size_t index, Task& task) {
+  // newest task of our own queue first, it works on the data we just touched
+  {
+    auto& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // steal the oldest task of the others, usually the largest piece of work
+  for (size_t i = 1; i < queues_.size(); ++i) {
+    auto& queue = *queues_[(index + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+  currentPool = this;
+  currentIndex = index;
+
+  while (true) {
+    Task task{};
+    if (pop(index, task)) {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{sleepMutex_};
+    wakeUp_.wait(lock, [this] {
+      return stop_ || queued_.load(std::memory_order_relaxed) > 0;
+    });
+
+    if (stop_ && queued_.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {
+  }
+}
+
+void TaskGroup::wait() {
+  while (pending_.load(std::memory_order_acquire) > 0) {
+    if (!pool_.runPendingTask()) {
+      std::this_thread::yield();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock{errorMutex_};
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+}
+
+}  // namespace rf
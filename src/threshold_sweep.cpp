@@ -0,0 +1,226 @@
+#include <rf/threshold_sweep.h>
+
+#include <rf/impurity.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace rf {
+
+namespace {
+
+/**
+ *  Term of a count in the sum of the criterion, see weightedImpurity
+ */
+template <SplitCriterion criterion>
+double term(uint32_t c) noexcept {
+  if constexpr (criterion == SplitCriterion::GINI) {
+    return static_cast<double>(c) * c;
+  } else {
+    return xlogx(c);
+  }
+}
+
+template <SplitCriterion criterion>
+ThresholdScore sweepSorted(std::vector<std::pair<float, Label>> const& samples,
+                           size_t valid, LabelHistogram const& entireSet,
+                           double totalImpurity) {
+  // the sums of the criterion of both sides are updated as the samples move
+  // from the right to the left
+  std::array<uint32_t, kMaxLabels> left{};
+  std::array<uint32_t, kMaxLabels> right{};
+  double leftSum = 0.0;
+  double rightSum = 0.0;
+  for (size_t label = 0; label < kMaxLabels; ++label) {
+    right[label] = entireSet.count(static_cast<Label>(label));
+    rightSum += term<criterion>(right[label]);
+  }
+
+  const auto total = static_cast<double>(samples.size());
+  ThresholdScore best{};
+
+  for (size_t i = 0; i < valid; ++i) {
+    const auto label = samples[i].second;
+    leftSum += term<criterion>(left[label] + 1) - term<criterion>(left[label]);
+    rightSum +=
+        term<criterion>(right[label] - 1) - term<criterion>(right[label]);
+    left[label]++;
+    right[label]--;
+
+    const auto lower = samples[i].first;
+    const auto upper = i + 1 < valid ? samples[i + 1].first
+                                     : std::numeric_limits<float>::infinity();
+    if (!(lower < upper) || i + 1 == samples.size()) {
+      continue;
+    }
+
+    const auto leftCount = static_cast<uint32_t>(i + 1);
+    const auto rightCount = static_cast<uint32_t>(samples.size() - i - 1);
+    const auto gain =
+        totalImpurity -
+        (weightedImpurity(leftCount, leftSum, criterion) +
+         weightedImpurity(rightCount, rightSum, criterion)) /
+            total;
+
+    if (gain > best.gain) {
+      // halved first, upper - lower overflows for large responses of
+      // opposite signs
+      auto threshold = lower / 2.0f + upper / 2.0f;
+      // adjacent floats, the lower response must stay on the left
+      if (!(lower < threshold)) {
+        threshold = upper;
+      }
+      best = {threshold, gain};
+    }
+  }
+
+  return best;
+}
+
+// Responses binned at a time, the bin indices of a block stay in cache
+constexpr size_t kBinBlock = 256;
+// Responses per bin used to estimate the quantiles
+constexpr size_t kQuantileSamplesPerBin = 16;
+
+/**
+ *  Edges of at most `bins` bins with about the same number of responses,
+ *  estimated from a strided subsample. Repeated edges are merged.
+ */
+void quantileEdges(Span<const float> responses, size_t bins,
+                   std::vector<float>& edges) {
+  thread_local std::vector<float> subsample{};
+  subsample.clear();
+
+  const auto step =
+      std::max<size_t>(1, responses.size() / (bins * kQuantileSamplesPerBin));
+  for (size_t i = 0; i < responses.size(); i += step) {
+    if (!std::isnan(responses[i])) {
+      subsample.push_back(responses[i]);
+    }
+  }
+  std::sort(subsample.begin(), subsample.end());
+
+  edges.clear();
+  for (size_t b = 1; b < bins && !subsample.empty(); ++b) {
+    const auto edge = subsample[b * subsample.size() / bins];
+    if (edges.empty() || edges.back() < edge) {
+      edges.push_back(edge);
+    }
+  }
+}
+
+}  // namespace
+
+ThresholdScore sweepThresholds(std::vector<std::pair<float, Label>>& samples,
+                               LabelHistogram const& entireSet,
+                               double totalImpurity,
+                               SplitCriterion criterion) {
+  // NaN can not be ordered, they stay on the right of any threshold
+  const auto valid = static_cast<size_t>(
+      std::partition(samples.begin(), samples.end(),
+                     [](auto const& s) { return !std::isnan(s.first); }) -
+      samples.begin());
+  std::sort(samples.begin(), samples.begin() + valid,
+            [](auto const& a, auto const& b) { return a.first < b.first; });
+
+  if (criterion == SplitCriterion::GINI) {
+    return sweepSorted<SplitCriterion::GINI>(samples, valid, entireSet,
+                                             totalImpurity);
+  }
+  return sweepSorted<SplitCriterion::ENTROPY>(samples, valid, entireSet,
+                                              totalImpurity);
+}
+
+ThresholdScore sweepBinnedThresholds(Span<const float> responses,
+                                     Span<const Label> labels,
+                                     LabelHistogram const& entireSet,
+                                     double totalImpurity, size_t bins,
+                                     SplitCriterion criterion) {
+  thread_local std::vector<float> edges{};
+  thread_local std::vector<uint32_t> binCounts{};
+
+  quantileEdges(responses, std::clamp<size_t>(bins, 2, 65536), edges);
+  if (edges.empty()) {
+    return {};
+  }
+
+  // only the labels present in the node get a column
+  size_t numberOfLabels = 0;
+  for (size_t label = 0; label < kMaxLabels; ++label) {
+    if (entireSet.count(static_cast<Label>(label)) > 0) {
+      numberOfLabels = label + 1;
+    }
+  }
+
+  const auto numberOfBins = edges.size() + 1;
+  binCounts.assign(numberOfBins * numberOfLabels, 0);
+
+  // The bin of a response is the number of edges not above it, NaN included.
+  // Counting edge by edge over a block of responses is a branchless loop the
+  // compiler vectorizes, unlike a binary search per response.
+  std::array<uint32_t, kBinBlock> bin{};
+  for (size_t first = 0; first < responses.size(); first += kBinBlock) {
+    const auto size = std::min(kBinBlock, responses.size() - first);
+    const auto* block = responses.data() + first;
+
+    std::fill_n(bin.begin(), size, 0u);
+    for (const auto edge : edges) {
+      for (size_t i = 0; i < size; ++i) {
+        bin[i] += !(block[i] < edge);
+      }
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+      binCounts[bin[i] * numberOfLabels + labels[first + i]]++;
+    }
+  }
+
+  const auto total = static_cast<double>(responses.size());
+
+  std::array<uint32_t, kMaxLabels> left{};
+  std::array<uint32_t, kMaxLabels> right{};
+  for (size_t label = 0; label < numberOfLabels; ++label) {
+    right[label] = entireSet.count(static_cast<Label>(label));
+  }
+  uint32_t leftCount = 0;
+  ThresholdScore best{};
+
+  for (size_t b = 0; b + 1 < numberOfBins; ++b) {
+    const auto* row = binCounts.data() + b * numberOfLabels;
+    uint32_t rowCount = 0;
+    for (size_t label = 0; label < numberOfLabels; ++label) {
+      left[label] += row[label];
+      right[label] -= row[label];
+      rowCount += row[label];
+    }
+    leftCount += rowCount;
+
+    // an empty bin does not move the boundary
+    if (rowCount == 0 || leftCount == 0 ||
+        leftCount == responses.size()) {
+      continue;
+    }
+
+    const auto leftSum = impuritySum(left.data(), numberOfLabels, criterion);
+    const auto rightSum =
+        impuritySum(right.data(), numberOfLabels, criterion);
+
+    const auto rightCount =
+        static_cast<uint32_t>(responses.size()) - leftCount;
+    const auto gain =
+        totalImpurity -
+        (weightedImpurity(leftCount, leftSum, criterion) +
+         weightedImpurity(rightCount, rightSum, criterion)) /
+            total;
+
+    if (gain > best.gain) {
+      best = {edges[b], gain};
+    }
+  }
+
+  return best;
+}
+
+}  // namespace rf
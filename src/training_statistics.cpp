@@ -0,0 +1,86 @@
+#include <rf/training_statistics.h>
+
+#include <algorithm>
+
+namespace rf {
+
+TrainingStatistics::Depth& TrainingStatistics::depth(size_t depth,
+                                                     size_t samples) {
+  if (depths_.size() <= depth) {
+    depths_.resize(depth + 1);
+  }
+
+  auto& stats = depths_[depth];
+  const bool first = stats.splits == 0 && stats.leaves == 0;
+  stats.minSamples = first ? samples : std::min(stats.minSamples, samples);
+  stats.maxSamples = std::max(stats.maxSamples, samples);
+  stats.samples += samples;
+  return stats;
+}
+
+void TrainingStatistics::onSplit(SplitStatistics const& split) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& stats = depth(split.depth, split.samples);
+  stats.splits++;
+  stats.gainSum += split.gain;
+  stats.maxGain = std::max(stats.maxGain, split.gain);
+  stats.rejectedCandidates += split.rejectedCandidates;
+  stats.generateNodeSeconds += split.generateSeconds;
+  stats.scoreNodeSeconds += split.scoreSeconds;
+  stats.partitionNodeSeconds += split.partitionSeconds;
+}
+
+void TrainingStatistics::onLeaf(LeafStatistics const& leaf) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& stats = depth(leaf.depth, leaf.samples);
+  stats.leaves++;
+  stats.leafNodeSeconds += leaf.seconds;
+}
+
+std::vector<TrainingStatistics::Depth> TrainingStatistics::depths() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return depths_;
+}
+
+void TrainingStatistics::clear() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  depths_.clear();
+}
+
+void TrainingStatistics::writeJson(std::ostream& os) const {
+  const auto stats = depths();
+
+  size_t splits = 0;
+  size_t leaves = 0;
+  for (auto const& depth : stats) {
+    splits += depth.splits;
+    leaves += depth.leaves;
+  }
+
+  os << "{\n  \"splits\": " << splits << ",\n  \"leaves\": " << leaves
+     << ",\n  \"depths\": [";
+
+  for (size_t i = 0; i < stats.size(); ++i) {
+    auto const& depth = stats[i];
+    const auto nodes = depth.splits + depth.leaves;
+    const auto meanSamples =
+        nodes > 0 ? static_cast<double>(depth.samples) / nodes : 0.0;
+    const auto meanGain = depth.splits > 0 ? depth.gainSum / depth.splits : 0.0;
+
+    os << (i == 0 ? "\n" : ",\n") << "    {\"depth\": " << i
+       << ", \"splits\": " << depth.splits << ", \"leaves\": " << depth.leaves
+       << ", \"meanSamples\": " << meanSamples
+       << ", \"minSamples\": " << depth.minSamples
+       << ", \"maxSamples\": " << depth.maxSamples
+       << ", \"meanGain\": " << meanGain << ", \"maxGain\": " << depth.maxGain
+       << ", \"rejectedCandidates\": " << depth.rejectedCandidates
+       << ", \"generateNodeSeconds\": " << depth.generateNodeSeconds
+       << ", \"scoreNodeSeconds\": " << depth.scoreNodeSeconds
+       << ", \"partitionNodeSeconds\": " << depth.partitionNodeSeconds
+       << ", \"leafNodeSeconds\": " << depth.leafNodeSeconds << "}";
+  }
+
+  os << "\n  ]\n}\n";
+}
+
+}  // namespace rf